@@ -0,0 +1,60 @@
+//
+// Arena source file
+// Wiktor Franus, WUT 2017
+//
+
+#include "Arena.h"
+
+Arena::Arena()
+: current(nullptr)
+, limit(nullptr)
+{}
+
+Arena::Arena(Arena &&oth)
+: blocks(std::move(oth.blocks))
+, destructors(std::move(oth.destructors))
+, current(oth.current)
+, limit(oth.limit)
+{
+    oth.blocks.clear();
+    oth.destructors.clear();
+    oth.current = nullptr;
+    oth.limit = nullptr;
+}
+
+Arena &Arena::operator=(Arena &&oth) {
+    if (this != &oth) {
+        clear();
+        blocks = std::move(oth.blocks);
+        destructors = std::move(oth.destructors);
+        current = oth.current;
+        limit = oth.limit;
+        oth.blocks.clear();
+        oth.destructors.clear();
+        oth.current = nullptr;
+        oth.limit = nullptr;
+    }
+    return *this;
+}
+
+Arena::~Arena() {
+    clear();
+}
+
+void Arena::clear() {
+    // objects may refer to ones created earlier
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+        it->destroy(it->object);
+    }
+    destructors.clear();
+    blocks.clear();
+    current = nullptr;
+    limit = nullptr;
+}
+
+void Arena::newBlock(size_t minSize) {
+    size_t size = minSize > BLOCK_SIZE ? minSize : BLOCK_SIZE;
+    blocks.emplace_back(new char[size]);
+    current = blocks.back().get();
+    limit = current + size;
+}
@@ -0,0 +1,69 @@
+//
+// Bump allocator releasing all its objects at once
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_ARENA_H
+#define FRACTUS_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Objects are placed one after another in large blocks.
+ * Nothing is freed separately: destructors of objects which need them
+ * are run and all blocks are released when the arena is cleared.
+ */
+class Arena {
+public:
+    Arena();
+    Arena(Arena &&oth);
+    Arena &operator=(Arena &&oth);
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    template <typename T, typename... Args>
+    T *make(Args&&... args) {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            destructors.push_back({object, [](void *p) { static_cast<T*>(p)->~T(); }});
+        }
+        return object;
+    }
+
+    void *allocate(size_t size, size_t alignment) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+        if (p + size > reinterpret_cast<uintptr_t>(limit)) {
+            newBlock(size + alignment);
+            p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+        }
+        current = reinterpret_cast<char*>(p + size);
+        return reinterpret_cast<void*>(p);
+    }
+
+    // destroys all objects and releases memory
+    void clear();
+
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Destructor {
+        void *object;
+        void (*destroy)(void *object);
+    };
+
+    void newBlock(size_t minSize);
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<Destructor> destructors;
+    char *current;
+    char *limit;
+};
+
+#endif //FRACTUS_ARENA_H
@@ -0,0 +1,248 @@
+//
+// Assembler source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <cstring>
+
+#include "Assembler.h"
+
+static uint8_t low(Reg reg) {
+    return static_cast<uint8_t>(reg) & 7;
+}
+
+static bool extended(Reg reg) {
+    return static_cast<uint8_t>(reg) >= 8;
+}
+
+Assembler::Label Assembler::newLabel() {
+    labels.push_back(UNBOUND);
+    return labels.size() - 1;
+}
+
+void Assembler::bind(Label label) {
+    labels[label] = code.size();
+}
+
+void Assembler::int32(int32_t value) {
+    uint8_t bytes[4];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    code.insert(code.end(), bytes, bytes + 4);
+}
+
+void Assembler::rex(bool wide, Reg reg, Reg base) {
+    uint8_t prefix = 0x40 | (wide ? 8 : 0) | (extended(reg) ? 4 : 0) | (extended(base) ? 1 : 0);
+    if (prefix != 0x40) {
+        byte(prefix);
+    }
+}
+
+void Assembler::memory(Reg reg, Reg base, int32_t disp) {
+    memory(low(reg), base, disp);
+}
+
+void Assembler::memory(uint8_t extension, Reg base, int32_t disp) {
+    // mod 10: [base + disp32], rsp and r12 as base need SIB byte
+    byte(0x80 | (extension << 3) | low(base));
+    if (low(base) == 4) {
+        byte(0x24);
+    }
+    int32(disp);
+}
+
+void Assembler::direct(Reg reg, Reg rm) {
+    byte(0xC0 | (low(reg) << 3) | low(rm));
+}
+
+void Assembler::rel32(Label label) {
+    fixups.push_back({code.size(), label});
+    int32(0);
+}
+
+void Assembler::push(Reg reg) {
+    rex(false, Reg::RAX, reg);
+    byte(0x50 + low(reg));
+}
+
+void Assembler::pop(Reg reg) {
+    rex(false, Reg::RAX, reg);
+    byte(0x58 + low(reg));
+}
+
+void Assembler::ret() {
+    byte(0xC3);
+}
+
+void Assembler::load32(Reg dst, Reg base, int32_t disp) {
+    rex(false, dst, base);
+    byte(0x8B);
+    memory(dst, base, disp);
+}
+
+void Assembler::store32(Reg base, int32_t disp, Reg src) {
+    rex(false, src, base);
+    byte(0x89);
+    memory(src, base, disp);
+}
+
+void Assembler::store32(Reg base, int32_t disp, int32_t imm) {
+    rex(false, Reg::RAX, base);
+    byte(0xC7);
+    memory(0, base, disp);
+    int32(imm);
+}
+
+void Assembler::load64(Reg dst, Reg base, int32_t disp) {
+    rex(true, dst, base);
+    byte(0x8B);
+    memory(dst, base, disp);
+}
+
+void Assembler::move64(Reg dst, Reg src) {
+    rex(true, src, dst);
+    byte(0x89);
+    direct(src, dst);
+}
+
+void Assembler::move64(Reg dst, uint64_t imm) {
+    rex(true, Reg::RAX, dst);
+    byte(0xB8 + low(dst));
+    uint8_t bytes[8];
+    std::memcpy(bytes, &imm, sizeof(bytes));
+    code.insert(code.end(), bytes, bytes + 8);
+}
+
+void Assembler::move32(Reg dst, int32_t imm) {
+    rex(false, Reg::RAX, dst);
+    byte(0xB8 + low(dst));
+    int32(imm);
+}
+
+void Assembler::lea(Reg dst, Reg base, int32_t disp) {
+    rex(true, dst, base);
+    byte(0x8D);
+    memory(dst, base, disp);
+}
+
+void Assembler::alu32(AluOp op, Reg dst, Reg base, int32_t disp) {
+    rex(false, dst, base);
+    byte(static_cast<uint8_t>(op));
+    memory(dst, base, disp);
+}
+
+void Assembler::compare64(Reg left, Reg base, int32_t disp) {
+    rex(true, left, base);
+    byte(0x3B);
+    memory(left, base, disp);
+}
+
+void Assembler::compare32(Reg base, int32_t disp, int32_t imm) {
+    rex(false, Reg::RAX, base);
+    byte(0x81);
+    memory(7, base, disp);
+    int32(imm);
+}
+
+void Assembler::compare32(Reg reg, int32_t imm) {
+    rex(false, Reg::RAX, reg);
+    byte(0x81);
+    byte(0xF8 | low(reg));
+    int32(imm);
+}
+
+void Assembler::multiply32(Reg dst, Reg base, int32_t disp) {
+    rex(false, dst, base);
+    byte(0x0F);
+    byte(0xAF);
+    memory(dst, base, disp);
+}
+
+void Assembler::divide32(Reg divisor) {
+    byte(0x99);
+    rex(false, Reg::RAX, divisor);
+    byte(0xF7);
+    byte(0xF8 | low(divisor));
+}
+
+void Assembler::negate32(Reg reg) {
+    rex(false, Reg::RAX, reg);
+    byte(0xF7);
+    byte(0xD8 | low(reg));
+}
+
+void Assembler::test32(Reg left, Reg right) {
+    rex(false, right, left);
+    byte(0x85);
+    direct(right, left);
+}
+
+void Assembler::test64(Reg left, Reg right) {
+    rex(true, right, left);
+    byte(0x85);
+    direct(right, left);
+}
+
+void Assembler::xor32(Reg dst, Reg src) {
+    rex(false, src, dst);
+    byte(0x31);
+    direct(src, dst);
+}
+
+void Assembler::setIf(Cond cond, Reg dst) {
+    // setcc on low byte, then movzx to the whole register
+    byte(0x0F);
+    byte(0x90 | static_cast<uint8_t>(cond));
+    byte(0xC0 | low(dst));
+    byte(0x0F);
+    byte(0xB6);
+    direct(dst, dst);
+}
+
+void Assembler::increment32(Reg base, int32_t disp) {
+    rex(false, Reg::RAX, base);
+    byte(0xFF);
+    memory(0, base, disp);
+}
+
+void Assembler::decrement32(Reg base, int32_t disp) {
+    rex(false, Reg::RAX, base);
+    byte(0xFF);
+    memory(1, base, disp);
+}
+
+void Assembler::repMovsd() {
+    byte(0xF3);
+    byte(0xA5);
+}
+
+void Assembler::jump(Label label) {
+    byte(0xE9);
+    rel32(label);
+}
+
+void Assembler::jumpIf(Cond cond, Label label) {
+    byte(0x0F);
+    byte(0x80 | static_cast<uint8_t>(cond));
+    rel32(label);
+}
+
+void Assembler::jump(Reg target) {
+    rex(false, Reg::RAX, target);
+    byte(0xFF);
+    byte(0xE0 | low(target));
+}
+
+void Assembler::call(Reg target) {
+    rex(false, Reg::RAX, target);
+    byte(0xFF);
+    byte(0xD0 | low(target));
+}
+
+const std::vector<uint8_t> &Assembler::finish() {
+    for (const Fixup &fixup : fixups) {
+        int32_t distance = static_cast<int32_t>(labels[fixup.label] - (fixup.position + 4));
+        std::memcpy(&code[fixup.position], &distance, sizeof(distance));
+    }
+    fixups.clear();
+    return code;
+}
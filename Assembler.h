@@ -0,0 +1,118 @@
+//
+// Encoder of x86-64 machine code used by the JIT
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_ASSEMBLER_H
+#define FRACTUS_ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Reg : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// condition codes, as encoded in jcc and setcc
+enum class Cond : uint8_t {
+    Below = 0x2,
+    AboveEqual = 0x3,
+    Equal = 0x4,
+    NotEqual = 0x5,
+    BelowEqual = 0x6,
+    Above = 0x7,
+    Less = 0xC,
+    GreaterEqual = 0xD,
+    LessEqual = 0xE,
+    Greater = 0xF
+};
+
+// operations of form: register op= memory
+enum class AluOp : uint8_t {
+    Add = 0x03,
+    Subtract = 0x2B,
+    Compare = 0x3B
+};
+
+/**
+ * Appends instructions to a growing buffer. Memory operands are always
+ * [base + disp32], jumps always take rel32, so code is position independent
+ * except for absolute addresses loaded as immediates.
+ * Labels are resolved by finish().
+ */
+class Assembler {
+public:
+    using Label = size_t;
+
+    Label newLabel();
+    void bind(Label label);
+    size_t offsetOf(Label label) const {
+        return labels[label];
+    }
+    size_t position() const {
+        return code.size();
+    }
+
+    void push(Reg reg);
+    void pop(Reg reg);
+    void ret();
+
+    // mov reg, [base + disp] and back, 32 and 64 bit
+    void load32(Reg dst, Reg base, int32_t disp);
+    void store32(Reg base, int32_t disp, Reg src);
+    void store32(Reg base, int32_t disp, int32_t imm);
+    void load64(Reg dst, Reg base, int32_t disp);
+    void move64(Reg dst, Reg src);
+    void move64(Reg dst, uint64_t imm);
+    void move32(Reg dst, int32_t imm);
+    void lea(Reg dst, Reg base, int32_t disp);
+
+    void alu32(AluOp op, Reg dst, Reg base, int32_t disp);
+    void compare64(Reg left, Reg base, int32_t disp);
+    void compare32(Reg base, int32_t disp, int32_t imm);
+    void compare32(Reg reg, int32_t imm);
+    void multiply32(Reg dst, Reg base, int32_t disp);
+    void divide32(Reg divisor); // edx:eax / divisor, cdq included
+    void negate32(Reg reg);
+    void test32(Reg left, Reg right);
+    void test64(Reg left, Reg right);
+    void xor32(Reg dst, Reg src);
+    void setIf(Cond cond, Reg dst); // dst = cond ? 1 : 0, dst is one of rax..rbx
+    void increment32(Reg base, int32_t disp);
+    void decrement32(Reg base, int32_t disp);
+    void repMovsd();
+
+    void jump(Label label);
+    void jumpIf(Cond cond, Label label);
+    void jump(Reg target);
+    void call(Reg target);
+
+    // resolved code, labels cannot be bound after it
+    const std::vector<uint8_t> &finish();
+
+private:
+    static constexpr size_t UNBOUND = static_cast<size_t>(-1);
+
+    struct Fixup {
+        size_t position; // of rel32, relative to its end
+        Label label;
+    };
+
+    void byte(uint8_t b) {
+        code.push_back(b);
+    }
+    void int32(int32_t value);
+    void rex(bool wide, Reg reg, Reg base);
+    void memory(Reg reg, Reg base, int32_t disp);
+    void memory(uint8_t extension, Reg base, int32_t disp);
+    void direct(Reg reg, Reg rm);
+    void rel32(Label label);
+
+    std::vector<uint8_t> code;
+    std::vector<size_t> labels;
+    std::vector<Fixup> fixups;
+};
+
+#endif //FRACTUS_ASSEMBLER_H
@@ -18,19 +18,7 @@ void LogicalOp::accept(Visitor &v) const {
     v.visit(this);
 }
 
-void IntNode::accept(Visitor &v) const {
-    v.visit(this);
-}
-
-void FractNode::accept(Visitor &v) const {
-    v.visit(this);
-}
-
-void BoolNode::accept(Visitor &v) const {
-    v.visit(this);
-}
-
-void StringNode::accept(Visitor &v) const {
+void NumNode::accept(Visitor &v) const {
     v.visit(this);
 }
 
@@ -101,109 +89,41 @@ void ParamNode::accept(Visitor &v) const {
 
 /** empty methods **/
 ValType Node::evaluate(Interpreter *interpreter) {
-    return std::make_pair(Value(), Type::Void);
+    return ValType();
 }
 
-ValType NumNode::evaluate(Interpreter *interpreter) {
-    return std::make_pair(Value(), Type::Void);
+Completion Node::execute(Interpreter *interpreter) {
+    evaluate(interpreter);
+    return Completion::Normal;
 }
 
+
 ValType VarDeclNode::evaluate(Interpreter *interpreter) {
-    return std::make_pair(Value(), Type::Void);
+    return ValType();
 }
 
 ValType ProcDeclNode::evaluate(Interpreter *interpreter) {
-    return std::make_pair(Value(), Type::Void);
+    return ValType();
 }
 
 /** non-empty methods **/
-ValType FractNode::evaluate(Interpreter *interpreter) {
-    Value v;
-    v.fractVal = value;
-    return std::make_pair(v, Type::Fraction);
-}
-
-ValType IntNode::evaluate(Interpreter *interpreter) {
-    Value v;
-    v.intVal = value;
-    return std::make_pair(v, Type::Int);
-}
-
-ValType BoolNode::evaluate(Interpreter *interpreter) {
-    Value v;
-    v.boolVal = value;
-    return std::make_pair(v, Type::Bool);
-}
-
-ValType StringNode::evaluate(Interpreter *interpreter) {
-    Value v;
-    v.stringVal = value;
-    return std::make_pair(v, Type::String);
+ValType NumNode::evaluate(Interpreter *interpreter) {
+    return constant;
 }
 
 ValType BinOpNode::evaluate(Interpreter *interpreter) {
     ValType leftRes = left->evaluate(interpreter);
     ValType rightRes = right->evaluate(interpreter);
-    Value v;
-
-    if (leftRes.second != rightRes.second) {
-        throw std::runtime_error("Incompalible types");
-    }
-    switch (op) {
-        case PLUS:
-            // int, fraction or string operands are accepted
-            if ((leftRes.second == Type::Int && rightRes.second == Type::Int)
-                || (leftRes.second == Type::String && rightRes.second == Type::String)
-                || (leftRes.second == Type::Fraction && rightRes.second == Type::Fraction)) {
-                return ValType(leftRes + rightRes);
-            } else {
-                throw std::runtime_error("Operands must be two numbers, fractions or strings.");
-            }
-        case MINUS:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            return ValType(leftRes - rightRes);
-        case MULTSIGN:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            return ValType(leftRes * rightRes);
-        case DIVSIGN:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            interpreter->checkDifferentThanZero(rightRes);
-            return ValType(leftRes / rightRes);
-        case EQOP:
-            v.boolVal = leftRes == rightRes;
-            return std::make_pair(v, Type::Bool);
-        case NEQOP:
-            v.boolVal = leftRes != rightRes;
-            return std::make_pair(v, Type::Bool);
-        case LTOP:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            v.boolVal = leftRes < rightRes;
-            return std::make_pair(v, Type::Bool);
-        case LEOP:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            v.boolVal = leftRes <= rightRes;
-            return std::make_pair(v, Type::Bool);
-        case GTOP:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            v.boolVal = leftRes > rightRes;
-            return std::make_pair(v, Type::Bool);
-        case GEOP:
-            interpreter->checkNumberOperands(leftRes, rightRes);
-            v.boolVal = leftRes >= rightRes;
-            return std::make_pair(v, Type::Bool);
-        default:
-            break;
-    }
-    return std::make_pair(Value(), Type::Void); //should not happen
+    return operation(this, leftRes, rightRes);
 }
 
 ValType LogicalOp::evaluate(Interpreter *interpreter) {
     ValType leftRes = left->evaluate(interpreter);
 
-    if (op == OROP && interpreter->isTruthy(leftRes)) {
+    if (op == OROP && leftRes.boolVal()) {
         return leftRes;
     }
-    if (op == ANDOP && !interpreter->isTruthy(leftRes)) {
+    if (op == ANDOP && !leftRes.boolVal()) {
         return leftRes;
     }
 
@@ -211,258 +131,130 @@ ValType LogicalOp::evaluate(Interpreter *interpreter) {
 }
 
 ValType UnaryOpNode::evaluate(Interpreter *interpreter) {
-    ValType expRes = expression->evaluate(interpreter);
-
-    switch (op) {
-        case MINUS:
-            interpreter->checkNumberOperand(expRes);
-            if (expRes.second == Type::Int) {
-                expRes.first.intVal = -expRes.first.intVal;
-            }
-            if (expRes.second == Type::Fraction) {
-                expRes.first.fractVal.whole = -expRes.first.fractVal.whole;
-            }
-            return expRes;
-        case NOTSIGN: {
-            Value v;
-            v.boolVal = !interpreter->isTruthy(expRes);
-            return std::make_pair(v, Type::Bool);
-        }
-        default:
-            break;
-    }
-    return std::make_pair(Value(), Type::Void); //should not happen
-}
-
-ValType CompoundNode::evaluate(Interpreter *interpreter) {
-    ValType res;
-    ValType prevRetVal = interpreter->currContext().getReturnValue();
-    for (auto &&node : children) {
-        res = node->evaluate(interpreter);
-        ValType currRetVal = interpreter->currContext().getReturnValue();
-        if ((prevRetVal.second == Type::Void && currRetVal.second != Type::Void)
-            || (prevRetVal != currRetVal)) {
-            //std::cout << "RETURN" << std::endl;
-            break;
-        }
-    }
-    return res;
+    return interpreter->unaryOperation(op, expression->evaluate(interpreter));
 }
 
-ValType AssignNode::evaluate(Interpreter *interpreter) {
-    ValType expRes = right->evaluate(interpreter);
-
-    if (expRes.second == Type::Void) {
-        throw std::runtime_error("Cannot assign expression of type void.");
-    }
-
-    Descriptor *leftDescriptor = interpreter->currContext().getVariableDescriptor(left->name);
-    if (leftDescriptor->type != DescType::Var) {
-        throw std::runtime_error("Symbol before equal sign is not a valid variable.");
-    }
-
-    VarDescriptor *varDescriptor = static_cast<VarDescriptor*>(leftDescriptor);
-    const std::string &varTypeName = varDescriptor->typeDesc->name;
-
-    if (interpreter->typeNames[expRes.second] != varTypeName) {
-        throw std::runtime_error("Cannot assign expression, because types do not match.");
+Completion CompoundNode::execute(Interpreter *interpreter) {
+    for (Node *node : children) {
+        Completion completion = node->execute(interpreter);
+        if (completion != Completion::Normal) {
+            return completion;
+        }
     }
+    return Completion::Normal;
+}
 
-    interpreter->currContext().setVariableValue(left->name, expRes.first);
-    return expRes;
+Completion AssignNode::execute(Interpreter *interpreter) {
+    store(this, interpreter, right->evaluate(interpreter));
+    return Completion::Normal;
 }
 
-ValType IfNode::evaluate(Interpreter *interpreter) {
-    ValType cond = condition->evaluate(interpreter);
-    if (interpreter->isTruthy(cond)) {
-        return thenNode->evaluate(interpreter);
-    } else if (elseNode){
-        return elseNode->evaluate(interpreter);
+Completion IfNode::execute(Interpreter *interpreter) {
+    if (condition->evaluate(interpreter).boolVal()) {
+        return thenNode->execute(interpreter);
+    } else if (elseNode) {
+        return elseNode->execute(interpreter);
     }
-    return cond;
+    return Completion::Normal;
 }
 
-ValType WhileNode::evaluate(Interpreter *interpreter) {
-    ValType res;
-    while (interpreter->isTruthy(condition->evaluate(interpreter))) {
-        res = statement->evaluate(interpreter);
+Completion WhileNode::execute(Interpreter *interpreter) {
+    while (condition->evaluate(interpreter).boolVal()) {
+        Completion completion = statement->execute(interpreter);
+        if (completion != Completion::Normal) {
+            return completion;
+        }
     }
-    return res;
+    return Completion::Normal;
 }
 
-ValType ReturnNode::evaluate(Interpreter *interpreter) {
-    ValType retVal = expr->evaluate(interpreter);
-    interpreter->currContext().setReturnValue(retVal);
-    //std::cout << "New return value set!" << std::endl;
-    return retVal;
+Completion ReturnNode::execute(Interpreter *interpreter) {
+    if (tailCall) {
+        // arguments are evaluated in the current frame, then the callee takes it over
+        for (Node *arg : tailCall->arguments) {
+            interpreter->pushArgument(arg->evaluate(interpreter));
+        }
+        interpreter->replaceContextFrame(tailCall->descriptor, tailCall->arguments.size());
+        return Completion::TailCall;
+    }
+    // calls in the expression may move frames, so the current one is taken after it
+    ValType result = expr->evaluate(interpreter);
+    interpreter->currContext().setReturnValue(result);
+    return Completion::Return;
 }
 
 ValType VarNode::evaluate(Interpreter *interpreter) {
-    ValType &val = interpreter->currContext().getVariableValue(name);
-//    Descriptor *desc = interpreter->currContext().getVariableDescriptor(name);
-//    const std::string &typeName = static_cast<VarDescriptor*>(desc)->typeDesc->name;
-    return val;
+    return access(this, interpreter);
 }
 
-ValType ProgramNode::evaluate(Interpreter *interpreter) {
-    return block->evaluate(interpreter);
+Completion ProgramNode::execute(Interpreter *interpreter) {
+    return block->execute(interpreter);
 }
 
-ValType BlockNode::evaluate(Interpreter *interpreter) {
-    return compundStatement->evaluate(interpreter);
+Completion BlockNode::execute(Interpreter *interpreter) {
+    return compundStatement->execute(interpreter);
 }
 
 ValType TypeNode::evaluate(Interpreter *interpreter) {
-    Value v;
-    v.stringVal = typeName;
-    return std::make_pair(v, Type::String);
+    return ValType::fromString(SymbolTable::name(typeName));
 }
 
 ValType ParamNode::evaluate(Interpreter *interpreter) {
     return varNode->evaluate(interpreter);
 }
 
-// TODO: move these methods somewhere else
-ValType print(ProcCallNode *node, Interpreter *interpreter);
-ValType read(ProcCallNode *node, Interpreter *interpreter);
-
 ValType ProcCallNode::evaluate(Interpreter *interpreter) {
-    Descriptor *desc = interpreter->currContext().getVariableDescriptor(proc->name);
-    if (desc->type != DescType::Proc) {
-        std::runtime_error("Callable is not a defined procedure.");
-    }
-
-    ProcDescriptor *procDesc = static_cast<ProcDescriptor*>(desc);
-
-    // call builtin procedures
-    if (procDesc->name == "print") {
-        return print(this, interpreter);
-    } else if (procDesc->name == "read") {
-        return read(this, interpreter);
-    };
-
-    if (arguments.size() != procDesc->params.size()) {
-        std::runtime_error("Incorrect number of parameters: " + proc->name);
+    if (builtin) {
+        return builtin(this, interpreter);
     }
 
-    // evaluate proc call arguments in current context first
-    std::vector<ValType> evaluatedArgs;
+    // evaluate proc call arguments in current context first,
+    // they are pushed to places of parameters in the new frame
     for (size_t i = 0; i<arguments.size(); ++i) {
-        evaluatedArgs.emplace_back(arguments[i]->evaluate(interpreter));
+        interpreter->pushArgument(arguments[i]->evaluate(interpreter));
     }
 
-    // then create new context
-    interpreter->createNewContextFrame(procDesc->name);
-
-    for (size_t i = 0; i<evaluatedArgs.size(); ++i) {
-        //ValType val = arguments[i]->evaluate(interpreter);
-        ValType val = evaluatedArgs[i];
-        const std::string &parTypeName = procDesc->params[i]->typeDesc->name;
-        if (interpreter->typeNames[val.second] != parTypeName) {
-            std::runtime_error("Incorrect procedure argument type. Expected: " + parTypeName +
-            ", got: " + interpreter->typeNames[val.second]);
+    // pure procedure called again with equal arguments gives the same result
+    MemoCache *memo = descriptor->pure ? interpreter->getMemo() : nullptr;
+    std::vector<ValType> memoArgs;
+    if (memo) {
+        const ValType *args = interpreter->pushedArguments(arguments.size());
+        const ValType *cached = memo->find(descriptor, args, arguments.size());
+        if (cached) {
+            interpreter->dropArguments(arguments.size());
+            return *cached;
         }
-        interpreter->currContext().setVariableValue(procDesc->params[i]->name, val.first);
+        memoArgs.assign(args, args + arguments.size());
     }
 
-    BlockNode *procBody = interpreter->getProcNodes(procDesc->name)->blockNode;
-    procBody->evaluate(interpreter);
-
-    ValType retVal = interpreter->currContext().getReturnValue();
+    // then create new context
+    interpreter->createNewContextFrame(descriptor->scope, arguments.size());
 
-    if (interpreter->typeNames[retVal.second] != procDesc->retType) {
-        std::runtime_error("Incorrect procedure return type. Expected: " + procDesc->retType +
-                           ", got: " + interpreter->typeNames[retVal.second]);
+    // procedures called in tail position run in the same frame
+    const ProcDescriptor *callee = descriptor;
+    Completion completion;
+    while ((completion = callee->declaration->blockNode->execute(interpreter)) == Completion::TailCall) {
+        callee = interpreter->getTailCallee();
     }
+    interpreter->checkCompletion(completion, type, SymbolTable::name(callee->name));
+
+    ValType retVal = interpreter->currContext().getReturnValue();
 
     interpreter->popContextFrame();
+    if (memo) {
+        memo->insert(descriptor, memoArgs.data(), memoArgs.size(), retVal);
+    }
     return retVal;
 }
 
-ValType print(ProcCallNode *node, Interpreter *interpreter) {
+ValType builtinPrint(ProcCallNode *node, Interpreter *interpreter) {
     std::cout << node->arguments[0]->evaluate(interpreter) << std::endl;
-    return std::make_pair(Value(), Type::Void);
+    return ValType();
 }
 
-ValType read(ProcCallNode *node, Interpreter *interpreter) {
+ValType builtinRead(ProcCallNode *node, Interpreter *interpreter) {
     VarNode *varNode = static_cast<VarNode*>(node->arguments[0]);
-    ValType &val = interpreter->currContext().getVariableValue(varNode->name);
+    ValType &val = interpreter->currContext().getVariableValue(varNode->depth, varNode->slot);
     std::cin >> val;
-    return std::make_pair(Value(), Type::Void);
+    return ValType();
 }
-
-
-/**
- * Node d-tors
- */
-BinOpNode::~BinOpNode() {
-    delete left;
-    delete right;
-}
-
-UnaryOpNode::~UnaryOpNode() {
-    delete expression;
-}
-
-CompoundNode::~CompoundNode() {
-    for (auto &&node : children) {
-        delete node;
-    }
-}
-
-AssignNode::~AssignNode() {
-    delete left;
-    delete right;
-}
-
-IfNode::~IfNode() {
-    delete condition;
-    delete thenNode;
-    delete elseNode;
-}
-
-WhileNode::~WhileNode() {
-    delete condition;
-    delete statement;
-}
-
-ReturnNode::~ReturnNode() {
-    delete expr;
-}
-
-ProgramNode::~ProgramNode() {
-    delete block;
-}
-
-BlockNode::~BlockNode() {
-    for (auto &&node : varDeclarations) {
-        delete node;
-    }
-    for (auto &&node : procDeclarations) {
-        delete node;
-    }
-    delete compundStatement;
-}
-
-VarDeclNode::~VarDeclNode() {
-    delete varNode;
-}
-
-ParamNode::~ParamNode() {
-    delete varNode;
-}
-
-ProcDeclNode::~ProcDeclNode() {
-    delete returnType;
-    delete blockNode;
-    for (auto &&node : params) {
-        delete node;
-    }
-}
-
-ProcCallNode::~ProcCallNode() {
-    delete proc;
-    for (auto &&node : arguments) {
-        delete node;
-    }
-}
\ No newline at end of file
@@ -7,8 +7,8 @@
 #define FRACTUS_AST_H
 
 #include <vector>
-#include <memory>
 
+#include "Arena.h"
 #include "Scanner.h"
 #include "Scope.h"
 
@@ -21,65 +21,95 @@ struct ProcDeclNode;
 struct BlockNode;
 struct TypeNode;
 struct VarNode;
+struct ProcCallNode;
+struct BinOpNode;
+struct AssignNode;
+
+// first states of inline caches, nodes specialize themselves by them
+// on their first evaluation (see Quickening.cpp)
+ValType quickenBinary(BinOpNode *node, const ValType &left, const ValType &right);
+ValType &quickenVariable(VarNode *node, Interpreter *interpreter);
+void quickenAssign(AssignNode *node, Interpreter *interpreter, ValType &&value);
+
+/**
+ * How execution of a statement ended: normally, so the next statement
+ * runs, or by a return statement, which unwinds to the procedure call.
+ * Tail call unwinds the same way, then the call runs the callee in its frame.
+ */
+enum class Completion {
+    Normal,
+    Return,
+    TailCall
+};
 
 /**
- * AST nodes classes
+ * AST nodes classes.
+ * Nodes are allocated in Arena of the SyntaxTree and never deleted
+ * one by one, nodes having only pointer and number members are
+ * trivially destructible.
  */
 struct Node {
-    virtual ~Node() {}
     virtual void accept(Visitor &v) const = 0;
-    virtual ValType evaluate(Interpreter *interpreter) = 0;
+    // value of expression, statements have none
+    virtual ValType evaluate(Interpreter *interpreter);
+    // runs statement, by default expression evaluated for its side effects
+    virtual Completion execute(Interpreter *interpreter);
+
+    // static type of value, inferred by SemanticAnalyzer
+    mutable Type type = Type::Void;
+
+protected:
+    ~Node() = default;
 };
 
+// constant, its value is built once and copied by every evaluation
 struct NumNode : public Node {
-    NumNode(Token t) : token(t) {}
-    void accept(Visitor &v) {}
-    virtual ValType evaluate(Interpreter *interpreter);
+    NumNode(Token t, const ValType &v) : token(t), constant(v) {
+        type = v.type();
+    }
+    void accept(Visitor &v) const;
+    ValType evaluate(Interpreter *interpreter);
 
     Token token;
+    ValType constant;
 };
 
 struct IntNode : public NumNode {
-    IntNode(Token t, int v) : NumNode(t), value(v) {}
-    void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    IntNode(Token t, int v) : NumNode(t, ValType::fromInt(v)), value(v) {}
 
     int value;
 };
 
 struct FractNode : public NumNode {
-    FractNode(Token t, Fraction v) : NumNode(t), value(v) {}
-    void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    FractNode(Token t, Fraction v) : NumNode(t, ValType::fromFraction(v)), value(v) {}
 
     Fraction value;
 };
 
 struct BoolNode : public NumNode {
-    BoolNode(Token t, bool v) : NumNode(t), value(v) {}
-    void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    BoolNode(Token t, bool v) : NumNode(t, ValType::fromBool(v)), value(v) {}
 
     bool value;
 };
 
 struct StringNode : public NumNode {
-    StringNode(Token t, const std::string &v) : NumNode(t), value(v) {}
-    void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    StringNode(Token t, std::string_view v) : NumNode(t, ValType::fromString(std::string(v))), value(v) {}
 
     std::string value;
 };
 
 struct BinOpNode : public Node {
-    BinOpNode(Node *l, Token op, Node *r) : left(l), op(op), right(r) {}
-    ~BinOpNode();
+    using Operation = ValType (*)(BinOpNode *node, const ValType &left, const ValType &right);
+
+    BinOpNode(Node *l, Token op, Node *r) : left(l), op(op), right(r), operation(quickenBinary) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
     Node *left;
     Token op;
     Node *right;
+    // inline cache: operation for types of operands seen so far
+    Operation operation;
 };
 
 struct LogicalOp : public BinOpNode {
@@ -90,7 +120,6 @@ struct LogicalOp : public BinOpNode {
 
 struct UnaryOpNode : public Node {
     UnaryOpNode(Token op, Node* ex) : op(op), expression(ex) {}
-    ~UnaryOpNode();
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
@@ -100,29 +129,30 @@ struct UnaryOpNode : public Node {
 
 struct CompoundNode : public Node {
     CompoundNode() {}
-    ~CompoundNode();
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     std::vector<Node*> children;
 };
 
 struct AssignNode : public Node {
-    AssignNode(VarNode *l, Node *r) : left(l), right(r) {}
-    ~AssignNode();
+    using Store = void (*)(AssignNode *node, Interpreter *interpreter, ValType &&value);
+
+    AssignNode(VarNode *l, Node *r) : left(l), right(r), store(quickenAssign) {}
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     VarNode *left;
     Node *right;
+    // inline cache: store to resolved variable for type of values seen so far
+    Store store;
 };
 
 struct IfNode : public Node {
     IfNode(Node *c, Node *t, Node *e)
             : condition(c), thenNode(t), elseNode(e) {}
-    ~IfNode();
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     Node *condition;
     Node *thenNode;
@@ -132,36 +162,43 @@ struct IfNode : public Node {
 struct WhileNode : public Node {
     WhileNode(Node *c, Node *s)
             : condition(c), statement(s) {}
-    ~WhileNode();
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     Node *condition;
     Node *statement;
 };
 
 struct ReturnNode : public Node {
-    ReturnNode(Node *e) : expr(e) {}
-    ~ReturnNode();
+    ReturnNode(Node *e) : expr(e), tailCall(nullptr) {}
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     Node *expr;
+    // call of user procedure returned by procedure, set by SemanticAnalyzer
+    mutable ProcCallNode *tailCall;
 };
 
 struct VarNode : public Node {
-    VarNode(const std::string &n) : name(n) {}
+    using Access = ValType &(*)(VarNode *node, Interpreter *interpreter);
+
+    VarNode(Symbol n) : name(n), depth(0), slot(0), access(quickenVariable) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
-    std::string name;
+    Symbol name;
+    // lexical address resolved by SemanticAnalyzer:
+    // number of scopes to go out and slot in frame of that scope
+    mutable unsigned int depth;
+    mutable unsigned int slot;
+    // inline cache: storage of the variable, resolved by its first access
+    Access access;
 };
 
 struct ProgramNode : public Node {
     ProgramNode(const std::string &n, BlockNode* b) : name(n), block(b) {}
-    ~ProgramNode();
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     std::string name;
     BlockNode *block;
@@ -170,9 +207,8 @@ struct ProgramNode : public Node {
 struct BlockNode : public Node {
     BlockNode(std::vector<VarDeclNode*> &vd, std::vector<ProcDeclNode*> &pd, CompoundNode* cS)
             : varDeclarations(vd), procDeclarations(pd), compundStatement(cS) {}
-    ~BlockNode();
     void accept(Visitor &v) const;
-    ValType evaluate(Interpreter *interpreter);
+    Completion execute(Interpreter *interpreter);
 
     std::vector<VarDeclNode*> varDeclarations;
     std::vector<ProcDeclNode*> procDeclarations;
@@ -180,56 +216,73 @@ struct BlockNode : public Node {
 };
 
 struct VarDeclNode : public Node {
-    VarDeclNode(VarNode* vn, const std::shared_ptr<TypeNode> &tn) : varNode(vn), typeNode(tn) {}
-    ~VarDeclNode();
+    VarDeclNode(VarNode* vn, TypeNode *tn) : varNode(vn), typeNode(tn) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
     VarNode *varNode;
-    std::shared_ptr<TypeNode> typeNode; //multiple VarDeclNodes use the same TypeNode object
-    //TypeNode *typeNode;
+    TypeNode *typeNode; //multiple VarDeclNodes use the same TypeNode object
 };
 
 struct TypeNode : public Node {
-    TypeNode(const std::string &tn) : typeName(tn) {}
+    TypeNode(Symbol tn) : typeName(tn) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
-    std::string typeName;
+    Symbol typeName;
 };
 
 struct ParamNode : public Node {
-    ParamNode(VarNode* vn, const std::shared_ptr<TypeNode> &tn) : varNode(vn), typeNode(tn) {}
-    ~ParamNode();
+    ParamNode(VarNode* vn, TypeNode *tn) : varNode(vn), typeNode(tn) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
     VarNode *varNode;
-    std::shared_ptr<TypeNode> typeNode;
-    //TypeNode *typeNode;
+    TypeNode *typeNode;
 };
 
 struct ProcDeclNode : public Node {
-    ProcDeclNode(const std::string &n, TypeNode* rt, std::vector<ParamNode*> &p, BlockNode* b)
-            : name(n), returnType(rt), params(p), blockNode(b) {}
-    ~ProcDeclNode();
+    ProcDeclNode(Symbol n, TypeNode* rt, std::vector<ParamNode*> &p, BlockNode* b)
+            : name(n), returnType(rt), params(p), blockNode(b), descriptor(nullptr) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
-    std::string name;
+    Symbol name;
     TypeNode* returnType;
     std::vector<ParamNode*> params; // vec of ParamNodes
     BlockNode *blockNode;
+    // set by SemanticAnalyzer, names of nested procedures need not be unique
+    mutable const ProcDescriptor *descriptor;
 };
 
 struct ProcCallNode : public Node {
-    ProcCallNode(VarNode *vn, std::vector<Node*> a) : proc(vn), arguments(a) {}
-    ~ProcCallNode();
+    using BuiltinHandler = ValType (*)(ProcCallNode *node, Interpreter *interpreter);
+
+    ProcCallNode(VarNode *vn, std::vector<Node*> a)
+            : proc(vn), arguments(a), descriptor(nullptr), builtin(nullptr) {}
     void accept(Visitor &v) const;
     ValType evaluate(Interpreter *interpreter);
 
     VarNode *proc;
     std::vector<Node*> arguments;
+    // callee bound by SemanticAnalyzer: declaration and scope
+    // of the procedure or handler of builtin one
+    mutable const ProcDescriptor *descriptor;
+    mutable BuiltinHandler builtin;
+};
+
+// builtin procedures
+ValType builtinPrint(ProcCallNode *node, Interpreter *interpreter);
+ValType builtinRead(ProcCallNode *node, Interpreter *interpreter);
+
+/**
+ * Parsed program: root node and arena owning all nodes of the tree
+ */
+struct SyntaxTree {
+    SyntaxTree() : program(nullptr) {}
+
+    Arena arena;
+    ProgramNode *program;
 };
 
 /**
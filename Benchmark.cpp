@@ -0,0 +1,302 @@
+//
+// Microbenchmarks of interpreter kernels
+// Wiktor Franus, WUT 2017
+//
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Fraction.h"
+#include "Interpreter.h"
+#include "Numeric.h"
+#include "Parser.h"
+#include "Reader.h"
+#include "Scanner.h"
+#include "SemanticAnalyzer.h"
+#include "Specializer.h"
+
+/**
+ * Benchmark runner
+ */
+
+struct Benchmark {
+    const char *name;
+    void (*run)(int iterations);
+    int iterations;
+    size_t (*bytesPerOp)(); // input size for throughput, optional
+};
+
+// keeps results alive so the measured work is not optimized away
+static volatile uint64_t sink;
+
+static void measure(const Benchmark &b) {
+    auto start = std::chrono::steady_clock::now();
+    b.run(b.iterations);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << b.name << ": " << ms << " ms, "
+              << ms * 1e6 / b.iterations << " ns/op";
+    if (b.bytesPerOp) {
+        double mb = static_cast<double>(b.bytesPerOp()) * b.iterations / (1024 * 1024);
+        std::cout << ", " << mb / (ms / 1000) << " MB/s";
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * Numeric kernels
+ */
+
+// previous implementation, kept as a reference point
+static uint64_t subtractionCommonDivisor(uint64_t x, uint64_t y) {
+    while (x != y) {
+        if (x > y) x = x - y;
+        else y = y - x;
+    }
+    return x;
+}
+
+static uint64_t euclidCommonDivisor(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// coprime denominators of very different magnitude (worst case for
+// subtraction), small enough for their sum to fit in a Fraction
+static const std::vector<std::pair<uint64_t, uint64_t>> &coprimePairs() {
+    static std::vector<std::pair<uint64_t, uint64_t>> pairs;
+    if (pairs.empty()) {
+        std::mt19937 gen(2017);
+        std::uniform_int_distribution<uint64_t> large(1u << 18, (1u << 20) - 1);
+        std::uniform_int_distribution<uint64_t> small(1u << 6, (1u << 11) - 1);
+        while (pairs.size() < 1024) {
+            uint64_t a = large(gen), b = small(gen);
+            if (euclidCommonDivisor(a, b) == 1) {
+                pairs.emplace_back(a, b);
+            }
+        }
+    }
+    return pairs;
+}
+
+static void gcdSubtraction(int iterations) {
+    const auto &pairs = coprimePairs();
+    uint64_t acc = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto &p = pairs[i % pairs.size()];
+        acc += subtractionCommonDivisor(p.first, p.second);
+    }
+    sink = acc;
+}
+
+static void gcdEuclid(int iterations) {
+    const auto &pairs = coprimePairs();
+    uint64_t acc = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto &p = pairs[i % pairs.size()];
+        acc += euclidCommonDivisor(p.first, p.second);
+    }
+    sink = acc;
+}
+
+static void gcdBinary(int iterations) {
+    const auto &pairs = coprimePairs();
+    uint64_t acc = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto &p = pairs[i % pairs.size()];
+        acc += greatestCommonDivisor(p.first, p.second);
+    }
+    sink = acc;
+}
+
+static void fractionAddCompare(int iterations) {
+    const auto &pairs = coprimePairs();
+    uint64_t acc = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto &p = pairs[i % pairs.size()];
+        Fraction a(0, 1, static_cast<int>(p.first));
+        Fraction b(0, 1, static_cast<int>(p.second));
+        Fraction sum = a + b;
+        acc += sum.denominator + (a < b);
+    }
+    sink = acc;
+}
+
+/**
+ * Front end
+ */
+
+// large generated program, similar to machine generated scripts
+static const std::string &generatedSource() {
+    static std::string source;
+    if (source.empty()) {
+        source = "program generated;\n    var a, b: integer;\n        f: fraction;\n";
+        for (int p = 0; p < 500; ++p) {
+            std::string n = std::to_string(p);
+            source += "    integer Proc" + n + "(integer x);\n        var y: integer;\n        begin\n";
+            for (int k = 0; k < 60; ++k) {
+                std::string c = std::to_string(k);
+                source += "            y = x * " + c + " + (x - " + c + ") / (" + c + " + 1) - y * 2;\n";
+                source += "            if ((y > " + c + ") and ((x < 3) or !(y == 2))) then y = y - 1 else f = f + 1.1_3;\n";
+                source += "            print(\"value of y\"); # comment\n";
+            }
+            source += "            return y\n        end;\n";
+        }
+        source += "    begin\n        a = Proc0(1);\n        print(a)\n    end.\n";
+    }
+    return source;
+}
+
+static size_t generatedSourceSize() {
+    return generatedSource().size();
+}
+
+static void lexer(int iterations) {
+    const std::string &source = generatedSource();
+    uint64_t acc = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Reader reader(source.data(), source.size());
+        Scanner scanner(&reader);
+        Token t;
+        while ((t = scanner.nextSymbol()) != END_OF_FILE) {
+            acc += t;
+        }
+    }
+    sink = acc;
+}
+
+// arithmetic heavy program: long operator chains and deep parentheses
+static const std::string &expressionSource() {
+    static std::string source;
+    if (source.empty()) {
+        source = "program expressions;\n    var x, y: integer;\n    begin\n        x = 1";
+        for (int k = 0; k < 20000; ++k) {
+            std::string c = std::to_string(k % 97 + 1);
+            std::string nested = c;
+            for (int d = 0; d < 40; ++d) {
+                nested = d % 2 ? "(" + nested + " * x)" : "(-" + nested + " + y)";
+            }
+            source += ";\n        y = x * " + c + " - y / " + c + " + " + c + " * x * x - " + nested;
+        }
+        source += "\n    end.\n";
+    }
+    return source;
+}
+
+static size_t expressionSourceSize() {
+    return expressionSource().size();
+}
+
+static uint64_t parseSource(const std::string &source, int iterations) {
+    uint64_t acc = 0;
+    // parser reports program name
+    std::streambuf *out = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < iterations; ++i) {
+        Reader reader(source.data(), source.size());
+        Scanner scanner(&reader);
+        Parser parser(scanner);
+        SyntaxTree tree = parser.parse();
+        acc += tree.program->block->procDeclarations.size() + tree.program->block->compundStatement->children.size();
+    }
+    std::cout.rdbuf(out);
+    std::cout.clear();
+    return acc;
+}
+
+static void parser(int iterations) {
+    sink = parseSource(generatedSource(), iterations);
+}
+
+static void parserExpression(int iterations) {
+    sink = parseSource(expressionSource(), iterations);
+}
+
+/**
+ * Execution, time per iteration of a loop doing a few integer operations
+ */
+
+static void runLoop(int iterations, ExecutionMode mode) {
+    std::string source = "program loop;\n    var i, s: integer;\n    begin\n"
+                         "        while (i < " + std::to_string(iterations) + ") do begin\n"
+                         "            s = s + i * 2 - s / 3;\n"
+                         "            i = i + 1\n"
+                         "        end;\n"
+                         "        print(s)\n    end.\n";
+    // front end and program report to standard output
+    std::streambuf *out = std::cout.rdbuf(nullptr);
+    Reader reader(source.data(), source.size());
+    Scanner scanner(&reader);
+    Parser parser(scanner);
+    SyntaxTree tree = parser.parse();
+    SemanticAnalyzer analyzer;
+    analyzer.visit(tree.program);
+    if (mode == ExecutionMode::TreeWalking) {
+        Specializer(tree.arena).specialize(tree.program);
+    }
+    Interpreter interpreter(analyzer.getPrototypes(), tree.program, mode);
+    interpreter.interpret();
+    std::cout.rdbuf(out);
+    std::cout.clear();
+}
+
+static void executionTree(int iterations) {
+    runLoop(iterations, ExecutionMode::TreeWalking);
+}
+
+// no ahead-of-time specialization, nodes quicken on the first iteration
+static void executionAdaptive(int iterations) {
+    runLoop(iterations, ExecutionMode::Adaptive);
+}
+
+// threaded code unless built with FRACTUS_SWITCH_DISPATCH
+static void executionVM(int iterations) {
+    runLoop(iterations, ExecutionMode::Bytecode);
+}
+
+static void executionRegisters(int iterations) {
+    runLoop(iterations, ExecutionMode::Registers);
+}
+
+static void executionJit(int iterations) {
+    runLoop(iterations, ExecutionMode::Jit);
+}
+
+static const Benchmark benchmarks[] = {
+    {"gcd/subtraction", gcdSubtraction, 20000, nullptr},
+    {"gcd/euclid", gcdEuclid, 2000000, nullptr},
+    {"gcd/binary", gcdBinary, 2000000, nullptr},
+    {"fraction/add-compare", fractionAddCompare, 2000000, nullptr},
+    {"lexer", lexer, 10, generatedSourceSize},
+    {"parser", parser, 10, generatedSourceSize},
+    {"parser/expression", parserExpression, 10, expressionSourceSize},
+    {"execution/tree", executionTree, 5000000, nullptr},
+    {"execution/adaptive", executionAdaptive, 5000000, nullptr},
+    {"execution/vm", executionVM, 5000000, nullptr},
+    {"execution/registers", executionRegisters, 5000000, nullptr},
+    {"execution/jit", executionJit, 5000000, nullptr},
+};
+
+/**
+ * Runs all benchmarks, or only those whose names start with given prefixes
+ */
+int main(int argc, char* argv[]) {
+    for (const Benchmark &b : benchmarks) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            if (strncmp(b.name, argv[i], strlen(argv[i])) == 0) {
+                selected = true;
+            }
+        }
+        if (selected) {
+            measure(b);
+        }
+    }
+    return 0;
+}
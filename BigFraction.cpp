@@ -0,0 +1,233 @@
+//
+// BigFraction source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <climits>
+#include <stdexcept>
+
+#include "BigFraction.h"
+
+BigFraction::BigFraction()
+: big(nullptr)
+{}
+
+BigFraction::BigFraction(const Fraction &f)
+: small(f)
+, big(nullptr)
+{}
+
+BigFraction::BigFraction(const BigFraction &oth)
+: small(oth.small)
+, big(oth.big)
+{
+    retain();
+}
+
+BigFraction::BigFraction(BigFraction &&oth)
+: small(oth.small)
+, big(oth.big)
+{
+    oth.big = nullptr;
+}
+
+BigFraction::~BigFraction() {
+    release();
+}
+
+BigFraction &BigFraction::operator=(const BigFraction &oth) {
+    oth.retain();
+    release();
+    small = oth.small;
+    big = oth.big;
+    return *this;
+}
+
+BigFraction &BigFraction::operator=(BigFraction &&oth) {
+    if (this != &oth) {
+        release();
+        small = oth.small;
+        big = oth.big;
+        oth.big = nullptr;
+    }
+    return *this;
+}
+
+BigFraction BigFraction::fromRatio(const BigInt &num, const BigInt &den) {
+    if (den.isZero()) {
+        throw std::runtime_error("Denominator has to be different than 0!");
+    }
+    BigInt n = den.isNegative() ? -num : num;
+    BigInt d = den.abs();
+    BigInt g = greatestCommonDivisor(n, d);
+    if (g != BigInt(1)) {
+        BigInt rem;
+        divMod(n, g, n, rem);
+        divMod(d, g, d, rem);
+    }
+
+    // demote when whole part and denominator fit in int
+    if (n.fitsInt64() && d.fitsInt64() && d.toInt64() <= INT_MAX) {
+        int64_t whole = n.toInt64() / d.toInt64();
+        if (whole >= INT_MIN && whole <= INT_MAX) {
+            return BigFraction(Fraction::fromRatio(n.toInt64(), d.toInt64()));
+        }
+    }
+    BigFraction f;
+    f.big = new BigValue(std::move(n), std::move(d));
+    return f;
+}
+
+BigInt BigFraction::improperNumerator() const {
+    return big ? big->numerator : BigInt(small.improperNumerator());
+}
+
+BigInt BigFraction::denominator() const {
+    return big ? big->denominator : BigInt(small.denominator);
+}
+
+size_t BigFraction::hash() const {
+    if (big) {
+        return big->numerator.hash() * 31 + big->denominator.hash();
+    }
+    // representation is unique, so inline parts identify the value
+    return (static_cast<size_t>(static_cast<uint32_t>(small.whole)) * 31
+            + static_cast<uint32_t>(small.numerator)) * 31 + static_cast<uint32_t>(small.denominator);
+}
+
+/**
+ * Arithmetic: inline fast path, big integers when it overflows
+ */
+
+BigFraction operator-(const BigFraction &operand) {
+    if (!operand.big && operand.small.whole != INT_MIN) {
+        return -operand.small;
+    }
+    return BigFraction::fromRatio(-operand.improperNumerator(), operand.denominator());
+}
+
+BigFraction operator+(const BigFraction &left, const BigFraction &right) {
+    Fraction result;
+    if (!left.big && !right.big && checkedAdd(left.small, right.small, result)) {
+        return result;
+    }
+    BigInt ld = left.denominator(), rd = right.denominator();
+    return BigFraction::fromRatio(left.improperNumerator() * rd + right.improperNumerator() * ld, ld * rd);
+}
+
+BigFraction operator-(const BigFraction &left, const BigFraction &right) {
+    Fraction result;
+    if (!left.big && !right.big && checkedSubtract(left.small, right.small, result)) {
+        return result;
+    }
+    BigInt ld = left.denominator(), rd = right.denominator();
+    return BigFraction::fromRatio(left.improperNumerator() * rd - right.improperNumerator() * ld, ld * rd);
+}
+
+BigFraction operator*(const BigFraction &left, const BigFraction &right) {
+    Fraction result;
+    if (!left.big && !right.big && checkedMultiply(left.small, right.small, result)) {
+        return result;
+    }
+    return BigFraction::fromRatio(left.improperNumerator() * right.improperNumerator(),
+                                  left.denominator() * right.denominator());
+}
+
+BigFraction operator/(const BigFraction &left, const BigFraction &right) {
+    if (right.isZero()) {
+        throw std::runtime_error("Division by zero fraction.");
+    }
+    Fraction result;
+    if (!left.big && !right.big && checkedDivide(left.small, right.small, result)) {
+        return result;
+    }
+    return BigFraction::fromRatio(left.improperNumerator() * right.denominator(),
+                                  left.denominator() * right.improperNumerator());
+}
+
+bool operator==(const BigFraction &left, const BigFraction &right) {
+    if (!left.big && !right.big) {
+        return left.small == right.small;
+    }
+    // representation is unique, so big value never equals an inline one
+    return left.big && right.big
+           && left.big->numerator == right.big->numerator
+           && left.big->denominator == right.big->denominator;
+}
+
+bool operator!=(const BigFraction &left, const BigFraction &right) {
+    return !(left == right);
+}
+
+bool operator<(const BigFraction &left, const BigFraction &right) {
+    if (!left.big && !right.big) {
+        return left.small < right.small;
+    }
+    return left.improperNumerator() * right.denominator() < right.improperNumerator() * left.denominator();
+}
+
+bool operator>(const BigFraction &left, const BigFraction &right) {
+    return right < left;
+}
+
+bool operator<=(const BigFraction &left, const BigFraction &right) {
+    return !(right < left);
+}
+
+bool operator>=(const BigFraction &left, const BigFraction &right) {
+    return !(left < right);
+}
+
+/**
+ * I/O in the same mixed number notation as Fraction
+ */
+
+std::ostream& operator<<(std::ostream& os, const BigFraction& obj) {
+    if (!obj.big) {
+        return os << obj.small;
+    }
+    BigInt whole, rest;
+    divMod(obj.big->numerator, obj.big->denominator, whole, rest);
+    if (!whole.isZero()) {
+        os << whole.toString() << "." << rest.abs().toString();
+    } else {
+        os << rest.toString();
+    }
+    os << "_" << obj.big->denominator.toString();
+    return os;
+}
+
+std::istream& operator>>(std::istream& in, BigFraction& obj) {
+    std::string s;
+    size_t periodPos, sepPos;
+    in >> s;
+    periodPos = s.find('.');
+    sepPos = s.find('_');
+    if (periodPos == std::string::npos && sepPos == std::string::npos) {
+        return in;
+    }
+
+    BigInt whole, numerator, denominator(1);
+    try {
+        if (periodPos != std::string::npos) {
+            whole = BigInt::fromString(s.substr(0, periodPos));
+        }
+        if (sepPos != std::string::npos) {
+            if (periodPos == std::string::npos) {
+                numerator = BigInt::fromString(s.substr(0, sepPos));
+            } else {
+                numerator = BigInt::fromString(s.substr(periodPos + 1, sepPos - periodPos - 1));
+            }
+            denominator = BigInt::fromString(s.substr(sepPos + 1, s.length() - sepPos - 1));
+        }
+    } catch (const std::runtime_error &e) {
+        throw std::runtime_error("Invalid fraction: " + s);
+    }
+
+    // in mixed number notation "-1.1_2" minus applies to fraction part too
+    if (periodPos != std::string::npos && s[0] == '-') {
+        numerator = -numerator.abs();
+    }
+    obj = BigFraction::fromRatio(whole * denominator + numerator, denominator);
+    return in;
+}
@@ -0,0 +1,101 @@
+//
+// Fraction of unlimited precision
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_BIGFRACTION_H
+#define FRACTUS_BIGFRACTION_H
+
+#include <iostream>
+
+#include "BigInt.h"
+#include "Fraction.h"
+
+class ValType;
+
+/**
+ * Fraction which never overflows.
+ * Values fitting in Fraction are kept inline and use its arithmetic.
+ * Result which does not fit is promoted to heap allocated big integer
+ * ratio (shared, reference counted), result which fits again is demoted.
+ * Thanks to that every value has exactly one representation.
+ */
+class BigFraction {
+public:
+    BigFraction();
+    BigFraction(const Fraction &f);
+    BigFraction(const BigFraction &oth);
+    BigFraction(BigFraction &&oth);
+    ~BigFraction();
+    BigFraction &operator=(const BigFraction &oth);
+    BigFraction &operator=(BigFraction &&oth);
+
+    // canonical value of num / den, inline when it fits
+    static BigFraction fromRatio(const BigInt &num, const BigInt &den);
+
+    bool isSmall() const {
+        return big == nullptr;
+    }
+    const Fraction &smallValue() const {
+        return small;
+    }
+    bool isZero() const {
+        // zero always fits inline
+        return !big && small.isZero();
+    }
+
+    // improper fraction parts, for any representation
+    BigInt improperNumerator() const;
+    BigInt denominator() const;
+
+    // equal values have equal hashes, parts are not copied
+    size_t hash() const;
+
+    friend BigFraction operator-(const BigFraction &operand);
+    friend BigFraction operator+(const BigFraction &left, const BigFraction &right);
+    friend BigFraction operator-(const BigFraction &left, const BigFraction &right);
+    friend BigFraction operator*(const BigFraction &left, const BigFraction &right);
+    friend BigFraction operator/(const BigFraction &left, const BigFraction &right);
+    friend bool operator==(const BigFraction &left, const BigFraction &right);
+    friend bool operator<(const BigFraction &left, const BigFraction &right);
+
+    friend std::ostream& operator<<(std::ostream& os, const BigFraction& obj);
+    friend std::istream& operator>>(std::istream& in, BigFraction& obj);
+
+private:
+    /**
+     * Reduced improper fraction with positive denominator,
+     * shared by copies of a value
+     */
+    struct BigValue {
+        BigValue(BigInt num, BigInt den) : refCount(1), numerator(std::move(num)), denominator(std::move(den)) {}
+
+        unsigned int refCount;
+        BigInt numerator;
+        BigInt denominator;
+    };
+
+    void retain() const {
+        if (big) {
+            ++big->refCount;
+        }
+    }
+    void release() {
+        if (big && --big->refCount == 0) {
+            delete big;
+        }
+    }
+
+    Fraction small;
+    BigValue *big;
+
+    // ValType stores both representations in its own 16 bytes
+    friend class ValType;
+};
+
+bool operator!=(const BigFraction &left, const BigFraction &right);
+bool operator>(const BigFraction &left, const BigFraction &right);
+bool operator<=(const BigFraction &left, const BigFraction &right);
+bool operator>=(const BigFraction &left, const BigFraction &right);
+
+#endif //FRACTUS_BIGFRACTION_H
@@ -0,0 +1,354 @@
+//
+// BigInt source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "BigInt.h"
+
+static const uint32_t DECIMAL_CHUNK = 1000000000; // 10^9 fits in a limb
+static const int DECIMAL_CHUNK_DIGITS = 9;
+
+BigInt::BigInt()
+: negative(false)
+{}
+
+BigInt::BigInt(int64_t v)
+: negative(v < 0)
+{
+    uint64_t magnitude = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    while (magnitude) {
+        limbs.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt::BigInt(Limbs l, bool neg)
+: limbs(std::move(l))
+, negative(neg)
+{
+    trim(limbs);
+    if (limbs.empty()) {
+        negative = false;
+    }
+}
+
+BigInt BigInt::fromString(const std::string &s) {
+    size_t pos = 0;
+    bool neg = false;
+    if (pos < s.size() && (s[pos] == '-' || s[pos] == '+')) {
+        neg = s[pos] == '-';
+        ++pos;
+    }
+    if (pos == s.size()) {
+        throw std::runtime_error("Invalid number: " + s);
+    }
+
+    Limbs limbs;
+    while (pos < s.size()) {
+        // next chunk of up to 9 digits: limbs = limbs * 10^k + chunk
+        size_t len = std::min(s.size() - pos, static_cast<size_t>(DECIMAL_CHUNK_DIGITS));
+        uint64_t chunk = 0, scale = 1;
+        for (size_t i = 0; i < len; ++i) {
+            char c = s[pos + i];
+            if (c < '0' || c > '9') {
+                throw std::runtime_error("Invalid number: " + s);
+            }
+            chunk = chunk * 10 + (c - '0');
+            scale *= 10;
+        }
+        pos += len;
+
+        uint64_t carry = chunk;
+        for (uint32_t &limb : limbs) {
+            uint64_t t = static_cast<uint64_t>(limb) * scale + carry;
+            limb = static_cast<uint32_t>(t);
+            carry = t >> 32;
+        }
+        if (carry) {
+            limbs.push_back(static_cast<uint32_t>(carry));
+        }
+    }
+    return BigInt(std::move(limbs), neg);
+}
+
+bool BigInt::fitsInt64() const {
+    if (limbs.size() < 2) {
+        return true;
+    }
+    if (limbs.size() > 2) {
+        return false;
+    }
+    uint64_t magnitude = (static_cast<uint64_t>(limbs[1]) << 32) | limbs[0];
+    return magnitude <= static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+}
+
+int64_t BigInt::toInt64() const {
+    uint64_t magnitude = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs[i];
+    }
+    return negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+}
+
+size_t BigInt::hash() const {
+    size_t hash = negative ? 1 : 0;
+    for (uint32_t limb : limbs) {
+        hash = hash * 31 + limb;
+    }
+    return hash;
+}
+
+std::string BigInt::toString() const {
+    if (limbs.empty()) {
+        return "0";
+    }
+    Limbs rest = limbs;
+    std::vector<uint32_t> chunks;
+    while (!rest.empty()) {
+        chunks.push_back(divideSmall(rest, DECIMAL_CHUNK));
+    }
+
+    std::string s = negative ? "-" : "";
+    s += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        std::string digits = std::to_string(chunks[i]);
+        s.append(DECIMAL_CHUNK_DIGITS - digits.size(), '0');
+        s += digits;
+    }
+    return s;
+}
+
+BigInt BigInt::operator-() const {
+    return BigInt(limbs, !negative);
+}
+
+BigInt BigInt::abs() const {
+    return BigInt(limbs, false);
+}
+
+/**
+ * Magnitude arithmetic
+ */
+
+void BigInt::trim(Limbs &a) {
+    while (!a.empty() && a.back() == 0) {
+        a.pop_back();
+    }
+}
+
+int BigInt::compareMagnitude(const Limbs &a, const Limbs &b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+BigInt::Limbs BigInt::addMagnitude(const Limbs &a, const Limbs &b) {
+    const Limbs &longer = a.size() >= b.size() ? a : b;
+    const Limbs &shorter = a.size() >= b.size() ? b : a;
+    Limbs result(longer.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        uint64_t t = static_cast<uint64_t>(longer[i]) + (i < shorter.size() ? shorter[i] : 0) + carry;
+        result[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    result[longer.size()] = static_cast<uint32_t>(carry);
+    trim(result);
+    return result;
+}
+
+BigInt::Limbs BigInt::subtractMagnitude(const Limbs &a, const Limbs &b) {
+    Limbs result(a.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        int64_t t = static_cast<int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = t < 0;
+        result[i] = static_cast<uint32_t>(t + (borrow << 32));
+    }
+    trim(result);
+    return result;
+}
+
+BigInt::Limbs BigInt::multiplyMagnitude(const Limbs &a, const Limbs &b) {
+    if (a.empty() || b.empty()) {
+        return Limbs();
+    }
+    Limbs result(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            uint64_t t = static_cast<uint64_t>(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = static_cast<uint32_t>(t);
+            carry = t >> 32;
+        }
+        result[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+    trim(result);
+    return result;
+}
+
+uint32_t BigInt::divideSmall(Limbs &a, uint32_t divisor) {
+    uint64_t rem = 0;
+    for (size_t i = a.size(); i-- > 0;) {
+        uint64_t t = (rem << 32) | a[i];
+        a[i] = static_cast<uint32_t>(t / divisor);
+        rem = t % divisor;
+    }
+    trim(a);
+    return static_cast<uint32_t>(rem);
+}
+
+// Knuth's algorithm D (long division with normalized divisor)
+void BigInt::divideMagnitude(const Limbs &u, const Limbs &v, Limbs &quotient, Limbs &remainder) {
+    if (compareMagnitude(u, v) < 0) {
+        quotient.clear();
+        remainder = u;
+        return;
+    }
+    if (v.size() == 1) {
+        quotient = u;
+        uint32_t rem = divideSmall(quotient, v[0]);
+        remainder.clear();
+        if (rem) {
+            remainder.push_back(rem);
+        }
+        return;
+    }
+
+    const uint64_t base = 1ull << 32;
+    size_t n = v.size(), m = u.size();
+    int shift = __builtin_clz(v[n - 1]);
+
+    // normalize so that top limb of divisor has its highest bit set
+    Limbs vn(n), un(m + 1);
+    for (size_t i = n - 1; i > 0; --i) {
+        vn[i] = static_cast<uint32_t>((static_cast<uint64_t>(v[i]) << shift) | (static_cast<uint64_t>(v[i - 1]) >> (32 - shift)));
+    }
+    vn[0] = v[0] << shift;
+    un[m] = static_cast<uint32_t>(static_cast<uint64_t>(u[m - 1]) >> (32 - shift));
+    for (size_t i = m - 1; i > 0; --i) {
+        un[i] = static_cast<uint32_t>((static_cast<uint64_t>(u[i]) << shift) | (static_cast<uint64_t>(u[i - 1]) >> (32 - shift)));
+    }
+    un[0] = u[0] << shift;
+
+    quotient.assign(m - n + 1, 0);
+    for (size_t j = m - n + 1; j-- > 0;) {
+        // estimate quotient limb from top two limbs, correct at most twice
+        uint64_t num = (static_cast<uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num % vn[n - 1];
+        while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >= base) {
+                break;
+            }
+        }
+
+        // multiply and subtract
+        int64_t borrow = 0, t;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t p = qhat * vn[i];
+            t = static_cast<int64_t>(un[i + j]) - borrow - static_cast<int64_t>(p & 0xffffffff);
+            un[i + j] = static_cast<uint32_t>(t);
+            borrow = static_cast<int64_t>(p >> 32) - (t >> 32);
+        }
+        t = static_cast<int64_t>(un[j + n]) - borrow;
+        un[j + n] = static_cast<uint32_t>(t);
+
+        quotient[j] = static_cast<uint32_t>(qhat);
+        if (t < 0) {
+            // estimate was one too large, add divisor back
+            --quotient[j];
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t s = static_cast<uint64_t>(un[i + j]) + vn[i] + carry;
+                un[i + j] = static_cast<uint32_t>(s);
+                carry = s >> 32;
+            }
+            un[j + n] = static_cast<uint32_t>(un[j + n] + carry);
+        }
+    }
+    trim(quotient);
+
+    // denormalize remainder
+    remainder.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t pair = (static_cast<uint64_t>(un[i + 1]) << 32) | un[i];
+        remainder[i] = static_cast<uint32_t>(pair >> shift);
+    }
+    trim(remainder);
+}
+
+/**
+ * Signed operations
+ */
+
+BigInt operator+(const BigInt &left, const BigInt &right) {
+    if (left.negative == right.negative) {
+        return BigInt(BigInt::addMagnitude(left.limbs, right.limbs), left.negative);
+    }
+    if (BigInt::compareMagnitude(left.limbs, right.limbs) >= 0) {
+        return BigInt(BigInt::subtractMagnitude(left.limbs, right.limbs), left.negative);
+    }
+    return BigInt(BigInt::subtractMagnitude(right.limbs, left.limbs), right.negative);
+}
+
+BigInt operator-(const BigInt &left, const BigInt &right) {
+    return left + (-right);
+}
+
+BigInt operator*(const BigInt &left, const BigInt &right) {
+    return BigInt(BigInt::multiplyMagnitude(left.limbs, right.limbs), left.negative != right.negative);
+}
+
+bool operator==(const BigInt &left, const BigInt &right) {
+    return left.negative == right.negative && left.limbs == right.limbs;
+}
+
+bool operator!=(const BigInt &left, const BigInt &right) {
+    return !(left == right);
+}
+
+int compare(const BigInt &left, const BigInt &right) {
+    if (left.negative != right.negative) {
+        return left.negative ? -1 : 1;
+    }
+    int c = BigInt::compareMagnitude(left.limbs, right.limbs);
+    return left.negative ? -c : c;
+}
+
+bool operator<(const BigInt &left, const BigInt &right) {
+    return compare(left, right) < 0;
+}
+
+void divMod(const BigInt &dividend, const BigInt &divisor, BigInt &quotient, BigInt &remainder) {
+    if (divisor.isZero()) {
+        throw std::runtime_error("Operand must be different than 0.");
+    }
+    BigInt::Limbs q, r;
+    BigInt::divideMagnitude(dividend.limbs, divisor.limbs, q, r);
+    quotient = BigInt(std::move(q), dividend.negative != divisor.negative);
+    remainder = BigInt(std::move(r), dividend.negative);
+}
+
+BigInt greatestCommonDivisor(BigInt a, BigInt b) {
+    a.negative = false;
+    b.negative = false;
+    BigInt q, r;
+    while (!b.isZero()) {
+        divMod(a, b, q, r);
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
@@ -0,0 +1,71 @@
+//
+// Arbitrary precision integer
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_BIGINT_H
+#define FRACTUS_BIGINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Signed integer of unlimited size.
+ * Magnitude is kept in 32-bit limbs, least significant first,
+ * without leading zero limbs (zero has no limbs at all).
+ */
+class BigInt {
+public:
+    BigInt();
+    BigInt(int64_t v);
+
+    // decimal number with optional sign, throws on invalid input
+    static BigInt fromString(const std::string &s);
+
+    bool isZero() const {
+        return limbs.empty();
+    }
+    bool isNegative() const {
+        return negative;
+    }
+    bool fitsInt64() const;
+    int64_t toInt64() const;
+    std::string toString() const;
+    // equal numbers have equal hashes
+    size_t hash() const;
+
+    BigInt operator-() const;
+    BigInt abs() const;
+
+    friend BigInt operator+(const BigInt &left, const BigInt &right);
+    friend BigInt operator-(const BigInt &left, const BigInt &right);
+    friend BigInt operator*(const BigInt &left, const BigInt &right);
+    friend bool operator==(const BigInt &left, const BigInt &right);
+    friend int compare(const BigInt &left, const BigInt &right);
+
+    // truncating division, remainder takes sign of dividend
+    friend void divMod(const BigInt &dividend, const BigInt &divisor, BigInt &quotient, BigInt &remainder);
+    friend BigInt greatestCommonDivisor(BigInt a, BigInt b);
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    static int compareMagnitude(const Limbs &a, const Limbs &b);
+    static Limbs addMagnitude(const Limbs &a, const Limbs &b);
+    static Limbs subtractMagnitude(const Limbs &a, const Limbs &b); // |a| >= |b|
+    static Limbs multiplyMagnitude(const Limbs &a, const Limbs &b);
+    static void divideMagnitude(const Limbs &u, const Limbs &v, Limbs &quotient, Limbs &remainder);
+    static uint32_t divideSmall(Limbs &a, uint32_t divisor); // returns remainder
+    static void trim(Limbs &a);
+
+    BigInt(Limbs limbs, bool negative);
+
+    Limbs limbs;
+    bool negative;
+};
+
+bool operator!=(const BigInt &left, const BigInt &right);
+bool operator<(const BigInt &left, const BigInt &right);
+
+#endif //FRACTUS_BIGINT_H
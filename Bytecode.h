@@ -0,0 +1,98 @@
+//
+// Bytecode representation of FraCtuS programs
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_BYTECODE_H
+#define FRACTUS_BYTECODE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Scope.h"
+
+/**
+ * Instruction set of stack VM.
+ * Operands follow the opcode byte in the code stream,
+ * 16-bit operands are stored big-endian.
+ */
+enum class OpCode : uint8_t {
+    Constant,       // [idx16]    push constants[idx]
+    GetLocal,       // [slot16]   push frame slot
+    SetLocal,       // [slot16]   pop into frame slot
+    GetGlobal,      // [slot16]   push global slot
+    SetGlobal,      // [slot16]   pop into global slot
+    Pop,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Negate,
+    Not,
+    Jump,           // [off16]    ip += off
+    JumpIfFalse,    // [off16]    pop, ip += off if falsy
+    JumpIfFalseOrPop, // [off16]  ip += off if top is falsy, pop otherwise
+    JumpIfTrueOrPop,  // [off16]  ip += off if top is truthy, pop otherwise
+    Loop,           // [off16]    ip -= off
+    Call,           // [proc16]   call procedures[proc], arguments on stack
+    TailCall,       // [proc16]   call procedures[proc] in place of the current frame
+    Return,         //            pop return value and leave frame
+    MissingReturn,  //            end of non-void procedure reached, runtime error
+    Print,          //            pop and print
+    ReadLocal,      // [slot16]   read from stdin into frame slot
+    ReadGlobal,     // [slot16]   read from stdin into global slot
+    Halt
+};
+
+/**
+ * Sequence of instructions with its constant pool
+ */
+struct Chunk {
+    void write(OpCode op) {
+        code.push_back(static_cast<uint8_t>(op));
+    }
+
+    void writeShort(uint16_t operand) {
+        code.push_back(static_cast<uint8_t>(operand >> 8));
+        code.push_back(static_cast<uint8_t>(operand & 0xff));
+    }
+
+    // index fits in the operand, Compiler checks the number of constants
+    uint16_t addConstant(const ValType &value) {
+        constants.push_back(value);
+        return static_cast<uint16_t>(constants.size() - 1);
+    }
+
+    std::vector<uint8_t> code;
+    std::vector<ValType> constants;
+};
+
+/**
+ * Compiled procedure: code and layout of its frame.
+ * Parameters occupy the first slots of the frame.
+ */
+struct ProcPrototype {
+    std::string name;
+    Chunk chunk;
+    uint16_t paramCount = 0;
+    bool pure = false; // result depends only on arguments, may be memoized
+    std::vector<ValType> slots; // initial values of parameters and local variables
+};
+
+/**
+ * Whole compiled program
+ */
+struct CompiledProgram {
+    Chunk main;
+    std::vector<ValType> globals; // initial values of global variables
+    std::vector<ProcPrototype> procedures;
+};
+
+#endif //FRACTUS_BYTECODE_H
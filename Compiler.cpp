@@ -0,0 +1,274 @@
+//
+// Compiler source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <functional>
+#include <limits>
+#include <string>
+
+#include "Compiler.h"
+
+Compiler::Compiler(Prototypes *prototypes)
+: prototypes(prototypes)
+, program(nullptr)
+, chunk(nullptr)
+, inProcedure(false)
+{}
+
+CompiledProgram Compiler::compile(const ProgramNode *ast) {
+    CompiledProgram compiled;
+    program = &compiled;
+
+    // global variables (with builtin "true" and "false")
+    compiled.globals = prototypes->front()->getFrameLayout();
+
+    // procedures may be called before their body is compiled (recursion)
+    registerProcedures(ast->block);
+    compiled.procedures.resize(procNodes.size());
+    for (size_t i = 0; i < procNodes.size(); ++i) {
+        compileProcedure(procNodes[i], compiled.procedures[i]);
+    }
+
+    inProcedure = false;
+    chunk = &compiled.main;
+    constantIndexes.clear();
+    ast->block->accept(*this);
+    emit(OpCode::Halt);
+
+    program = nullptr;
+    chunk = nullptr;
+    return compiled;
+}
+
+void Compiler::registerProcedures(const BlockNode *block) {
+    for (ProcDeclNode *proc : block->procDeclarations) {
+        procIndexes[proc] = static_cast<uint16_t>(procNodes.size());
+        procNodes.push_back(proc);
+        registerProcedures(proc->blockNode);
+    }
+}
+
+void Compiler::compileProcedure(const ProcDeclNode *n, ProcPrototype &proto) {
+    Scope *procScope = n->descriptor->scope;
+    proto.name = SymbolTable::name(n->name);
+    proto.paramCount = static_cast<uint16_t>(n->params.size());
+    proto.pure = n->descriptor->pure;
+
+    proto.slots = procScope->getFrameLayout();
+
+    inProcedure = true;
+    chunk = &proto.chunk;
+    constantIndexes.clear();
+    n->blockNode->accept(*this);
+
+    // procedure without return statement returns void,
+    // other ones must not reach end of their body
+    if (n->returnType->typeName == SYM_VOID) {
+        emit(OpCode::Constant, constant(ValType()));
+        emit(OpCode::Return);
+    } else {
+        emit(OpCode::MissingReturn);
+    }
+}
+
+Compiler::Variable Compiler::resolve(const VarNode *n) const {
+    // main program frame is the global one
+    bool global = !inProcedure || n->depth > 0;
+    return {global, static_cast<uint16_t>(n->slot)};
+}
+
+/**
+ * Emitting helpers
+ */
+
+void Compiler::emit(OpCode op) {
+    chunk->write(op);
+}
+
+void Compiler::emit(OpCode op, uint16_t operand) {
+    chunk->write(op);
+    chunk->writeShort(operand);
+}
+
+size_t Compiler::emitJump(OpCode op) {
+    emit(op, 0xffff);
+    return chunk->code.size() - 2;
+}
+
+void Compiler::patchJump(size_t operandPos) {
+    size_t jump = chunk->code.size() - operandPos - 2;
+    if (jump > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Too much code to jump over.");
+    }
+    chunk->code[operandPos] = static_cast<uint8_t>(jump >> 8);
+    chunk->code[operandPos + 1] = static_cast<uint8_t>(jump & 0xff);
+}
+
+size_t Compiler::ConstantHash::operator()(const ValType &value) const {
+    return hashValue(value);
+}
+
+bool Compiler::ConstantEqual::operator()(const ValType &left, const ValType &right) const {
+    if (left.type() != right.type()) {
+        return false;
+    }
+    // void values never compare equal, but are all the same constant
+    return left.type() == Type::Void || left == right;
+}
+
+uint16_t Compiler::constant(const ValType &value) {
+    // equal literals of a chunk share one constant
+    auto it = constantIndexes.find(value);
+    if (it != constantIndexes.end()) {
+        return it->second;
+    }
+    if (chunk->constants.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Too many constants in one procedure.");
+    }
+    uint16_t index = chunk->addConstant(value);
+    constantIndexes.emplace(value, index);
+    return index;
+}
+
+void Compiler::emitLoop(size_t loopStart) {
+    size_t offset = chunk->code.size() - loopStart + 3;
+    if (offset > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Loop body too large.");
+    }
+    emit(OpCode::Loop, static_cast<uint16_t>(offset));
+}
+
+void Compiler::statement(const Node *n) {
+    n->accept(*this);
+    // procedure called as statement leaves its (ignored) result on stack
+    if (dynamic_cast<const ProcCallNode*>(n)) {
+        emit(OpCode::Pop);
+    }
+}
+
+/**
+ * Visitor methods
+ */
+
+void Compiler::visit(const BlockNode *n) {
+    // nested procedures are compiled separately
+    n->compundStatement->accept(*this);
+}
+
+void Compiler::visit(const CompoundNode *n) {
+    for (auto child : n->children) {
+        statement(child);
+    }
+}
+
+void Compiler::visit(const NumNode *n) {
+    emit(OpCode::Constant, constant(n->constant));
+}
+
+void Compiler::visit(const BinOpNode *n) {
+    n->left->accept(*this);
+    n->right->accept(*this);
+    switch (n->op) {
+        case PLUS:     emit(OpCode::Add); break;
+        case MINUS:    emit(OpCode::Subtract); break;
+        case MULTSIGN: emit(OpCode::Multiply); break;
+        case DIVSIGN:  emit(OpCode::Divide); break;
+        case EQOP:     emit(OpCode::Equal); break;
+        case NEQOP:    emit(OpCode::NotEqual); break;
+        case LTOP:     emit(OpCode::Less); break;
+        case LEOP:     emit(OpCode::LessEqual); break;
+        case GTOP:     emit(OpCode::Greater); break;
+        case GEOP:     emit(OpCode::GreaterEqual); break;
+        default:
+            throw std::runtime_error("Unknown binary operator.");
+    }
+}
+
+void Compiler::visit(const LogicalOp *n) {
+    // left operand is the result if it decides the outcome
+    n->left->accept(*this);
+    size_t shortCircuit = emitJump(n->op == OROP ? OpCode::JumpIfTrueOrPop : OpCode::JumpIfFalseOrPop);
+    n->right->accept(*this);
+    patchJump(shortCircuit);
+}
+
+void Compiler::visit(const UnaryOpNode *n) {
+    n->expression->accept(*this);
+    emit(n->op == NOTSIGN ? OpCode::Not : OpCode::Negate);
+}
+
+void Compiler::visit(const AssignNode *n) {
+    n->right->accept(*this);
+    Variable var = resolve(n->left);
+    emit(var.global ? OpCode::SetGlobal : OpCode::SetLocal, var.slot);
+}
+
+void Compiler::visit(const IfNode *n) {
+    n->condition->accept(*this);
+    size_t elseJump = emitJump(OpCode::JumpIfFalse);
+    statement(n->thenNode);
+    if (n->elseNode) {
+        size_t endJump = emitJump(OpCode::Jump);
+        patchJump(elseJump);
+        statement(n->elseNode);
+        patchJump(endJump);
+    } else {
+        patchJump(elseJump);
+    }
+}
+
+void Compiler::visit(const WhileNode *n) {
+    size_t loopStart = chunk->code.size();
+    n->condition->accept(*this);
+    size_t exitJump = emitJump(OpCode::JumpIfFalse);
+    statement(n->statement);
+    emitLoop(loopStart);
+    patchJump(exitJump);
+}
+
+void Compiler::visit(const ReturnNode *n) {
+    if (n->tailCall) {
+        // callee returns directly to our caller
+        emitCall(n->tailCall, OpCode::TailCall);
+        return;
+    }
+    n->expr->accept(*this);
+    emit(OpCode::Return);
+}
+
+void Compiler::visit(const VarNode *n) {
+    Variable var = resolve(n);
+    emit(var.global ? OpCode::GetGlobal : OpCode::GetLocal, var.slot);
+}
+
+void Compiler::visit(const ProcCallNode *n) {
+    // builtin procedures
+    if (n->builtin == builtinPrint) {
+        n->arguments[0]->accept(*this);
+        emit(OpCode::Print);
+        return;
+    }
+    if (n->builtin == builtinRead) {
+        const VarNode *varNode = dynamic_cast<const VarNode*>(n->arguments[0]);
+        if (!varNode) {
+            throw std::runtime_error("Argument of read must be a variable.");
+        }
+        Variable var = resolve(varNode);
+        emit(var.global ? OpCode::ReadGlobal : OpCode::ReadLocal, var.slot);
+        return;
+    }
+
+    emitCall(n, OpCode::Call);
+}
+
+void Compiler::emitCall(const ProcCallNode *n, OpCode op) {
+    auto it = procIndexes.find(n->descriptor->declaration);
+    if (it == procIndexes.end()) {
+        throw std::runtime_error("Cannot find declared procedure: " + SymbolTable::name(n->proc->name));
+    }
+    for (Node *arg : n->arguments) {
+        arg->accept(*this);
+    }
+    emit(op, it->second);
+}
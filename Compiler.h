@@ -0,0 +1,80 @@
+//
+// Compiler of checked AST to bytecode
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_COMPILER_H
+#define FRACTUS_COMPILER_H
+
+#include <unordered_map>
+
+#include "Ast.h"
+#include "Bytecode.h"
+
+/**
+ * Tree visitor emitting bytecode for stack VM.
+ * Expects AST already checked by SemanticAnalyzer.
+ */
+class Compiler : public Visitor {
+public:
+    using Prototypes = std::vector<Scope*>; // global scope first, then procedure scopes
+    Compiler(Prototypes *prototypes);
+
+    CompiledProgram compile(const ProgramNode *ast);
+
+    void visit(const BinOpNode *n);
+    void visit(const LogicalOp *n);
+    void visit(const NumNode *n);
+    void visit(const UnaryOpNode *n);
+    void visit(const CompoundNode *n);
+    void visit(const AssignNode *n);
+    void visit(const IfNode *n);
+    void visit(const WhileNode *n);
+    void visit(const ReturnNode *n);
+    void visit(const VarNode *n);
+    void visit(const ProgramNode *n) {}
+    void visit(const BlockNode *n);
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n) {}
+    void visit(const ProcCallNode *n);
+
+private:
+    struct Variable {
+        bool global;
+        uint16_t slot;
+    };
+
+    void registerProcedures(const BlockNode *block);
+    void compileProcedure(const ProcDeclNode *n, ProcPrototype &proto);
+    void statement(const Node *n);
+    Variable resolve(const VarNode *n) const;
+
+    void emit(OpCode op);
+    void emit(OpCode op, uint16_t operand);
+    size_t emitJump(OpCode op);
+    void patchJump(size_t operandPos);
+    void emitLoop(size_t loopStart);
+    // index of value in constants of current chunk, at most 65536 of them
+    uint16_t constant(const ValType &value);
+    void emitCall(const ProcCallNode *n, OpCode op);
+
+    // literals of different types never share a constant
+    struct ConstantHash {
+        size_t operator()(const ValType &value) const;
+    };
+    struct ConstantEqual {
+        bool operator()(const ValType &left, const ValType &right) const;
+    };
+
+    Prototypes *prototypes;
+    CompiledProgram *program;
+    Chunk *chunk; // chunk being currently emitted
+    std::unordered_map<ValType, uint16_t, ConstantHash, ConstantEqual> constantIndexes; // of current chunk
+    bool inProcedure;
+    std::unordered_map<const ProcDeclNode*, uint16_t> procIndexes;
+    std::vector<const ProcDeclNode*> procNodes;
+};
+
+#endif //FRACTUS_COMPILER_H
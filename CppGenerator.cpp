@@ -0,0 +1,442 @@
+//
+// CppGenerator source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <climits>
+#include <stdexcept>
+
+#include "CppGenerator.h"
+
+namespace {
+
+/**
+ * Finds what value of an expression depends on besides local variables:
+ * calls, which may change globals, print, read or fail, and global variables
+ */
+class DependencyFinder : public Visitor {
+public:
+    DependencyFinder(bool inProcedure)
+    : inProcedure(inProcedure)
+    , calls(false)
+    , globals(false)
+    {}
+
+    void visit(const BinOpNode *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const LogicalOp *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const NumNode *n) {}
+    void visit(const UnaryOpNode *n) {
+        n->expression->accept(*this);
+    }
+    void visit(const CompoundNode *n) {}
+    void visit(const AssignNode *n) {}
+    void visit(const IfNode *n) {}
+    void visit(const WhileNode *n) {}
+    void visit(const ReturnNode *n) {}
+    void visit(const VarNode *n) {
+        // all variables of the main program are global
+        if (!inProcedure || n->depth > 0) {
+            globals = true;
+        }
+    }
+    void visit(const ProgramNode *n) {}
+    void visit(const BlockNode *n) {}
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n) {}
+    void visit(const ProcCallNode *n) {
+        calls = true;
+        for (Node *arg : n->arguments) {
+            arg->accept(*this);
+        }
+    }
+
+    bool inProcedure;
+    bool calls;
+    bool globals;
+};
+
+const char *operatorText(Token op) {
+    switch (op) {
+        case PLUS:
+            return "+";
+        case MINUS:
+            return "-";
+        case MULTSIGN:
+            return "*";
+        case EQOP:
+            return "==";
+        case NEQOP:
+            return "!=";
+        case LTOP:
+            return "<";
+        case LEOP:
+            return "<=";
+        case GTOP:
+            return ">";
+        case GEOP:
+            return ">=";
+        case ANDOP:
+            return "&&";
+        case OROP:
+            return "||";
+        case NOTSIGN:
+            return "!";
+        default:
+            throw std::runtime_error("Unsupported operator in C++ generator");
+    }
+}
+
+// binary operation on computed operands, division checks its divisor
+std::string operation(Token op, const std::string &left, const std::string &right) {
+    if (op == DIVSIGN) {
+        return "fractus::divide(" + left + ", " + right + ")";
+    }
+    return "(" + left + " " + operatorText(op) + " " + right + ")";
+}
+
+std::string cppType(Type type) {
+    switch (type) {
+        case Type::Bool:
+            return "bool";
+        case Type::Int:
+            return "int";
+        case Type::String:
+            return "std::string";
+        case Type::Fraction:
+            return "BigFraction";
+        default:
+            return "void";
+    }
+}
+
+std::string variableName(Symbol name) {
+    return "v_" + SymbolTable::name(name);
+}
+
+std::string procedureName(Symbol name) {
+    return "p_" + SymbolTable::name(name);
+}
+
+std::string intLiteral(int value) {
+    // negative literal is negation of a positive one, which does not fit for the lowest value
+    if (value == INT_MIN) {
+        return "(-2147483647 - 1)";
+    }
+    if (value < 0) {
+        return "(" + std::to_string(value) + ")";
+    }
+    return std::to_string(value);
+}
+
+std::string quoted(const std::string &text) {
+    static const char digits[] = "01234567";
+    std::string literal = "\"";
+    for (char c : text) {
+        unsigned char code = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += c;
+        } else if (code < 0x20 || code >= 0x7F) {
+            // three octal digits, so a following digit is not taken into the escape
+            literal += '\\';
+            literal += digits[code >> 6];
+            literal += digits[(code >> 3) & 7];
+            literal += digits[code & 7];
+        } else {
+            literal += c;
+        }
+    }
+    return literal + "\"";
+}
+
+}
+
+CppGenerator::CppGenerator()
+: inProcedure(false)
+{}
+
+std::string CppGenerator::generate(const ProgramNode *ast) {
+    out.str("");
+    constants.str("");
+    constantNames.clear();
+    procedures.clear();
+    collectProcedures(ast->block);
+
+    // builtin constants are variables which can be assigned as well,
+    // most programs never read them
+    inProcedure = false;
+    indentation.clear();
+    out << "// global variables\n";
+    out << "[[maybe_unused]] static bool " << variableName(SYM_TRUE) << " = true;\n";
+    out << "[[maybe_unused]] static bool " << variableName(SYM_FALSE) << " = false;\n";
+    for (VarDeclNode *declaration : ast->block->varDeclarations) {
+        out << "static ";
+        declaration->accept(*this);
+    }
+
+    // procedures can call each other in any order
+    out << "\n// procedures\n";
+    for (const ProcDeclNode *proc : procedures) {
+        out << "static " << signature(proc) << ";\n";
+    }
+    for (const ProcDeclNode *proc : procedures) {
+        proc->accept(*this);
+    }
+
+    inProcedure = false;
+    indentation = "    ";
+    out << "\nstatic void program() {\n";
+    statement(ast->block->compundStatement);
+    out << "}\n\n";
+    out << "int main() {\n";
+    out << "    return fractus::run(program);\n";
+    out << "}\n";
+
+    std::ostringstream source;
+    source << "// Program " << ast->name << " translated to C++ by fractus --emit-cpp\n\n";
+    source << "#include \"CppRuntime.h\"\n\n";
+    if (!constantNames.empty()) {
+        source << "// literals\n" << constants.str() << "\n";
+    }
+    source << out.str();
+    return source.str();
+}
+
+void CppGenerator::collectProcedures(const BlockNode *block) {
+    for (const ProcDeclNode *proc : block->procDeclarations) {
+        procedures.push_back(proc);
+        collectProcedures(proc->blockNode);
+    }
+}
+
+std::string CppGenerator::signature(const ProcDeclNode *n) const {
+    std::string text = cppType(valueType(n->returnType->typeName)) + " " + procedureName(n->name) + "(";
+    for (size_t i = 0; i < n->params.size(); ++i) {
+        const ParamNode *param = n->params[i];
+        if (i > 0) {
+            text += ", ";
+        }
+        text += cppType(valueType(param->typeNode->typeName)) + " " + variableName(param->varNode->name);
+    }
+    return text + ")";
+}
+
+/**
+ * Declarations
+ */
+
+void CppGenerator::visit(const VarDeclNode *n) {
+    // variables start with the same values as in frames of the interpreter
+    Type type = valueType(n->typeNode->typeName);
+    out << cppType(type) << " " << variableName(n->varNode->name);
+    if (type == Type::Int) {
+        out << " = 0";
+    } else if (type == Type::Bool) {
+        out << (n->varNode->name == SYM_TRUE ? " = true" : " = false");
+    }
+    out << ";\n";
+}
+
+void CppGenerator::visit(const ProcDeclNode *n) {
+    inProcedure = true;
+    indentation = "    ";
+    out << "\nstatic " << signature(n) << " {\n";
+    for (VarDeclNode *declaration : n->blockNode->varDeclarations) {
+        out << indentation;
+        declaration->accept(*this);
+    }
+    statement(n->blockNode->compundStatement);
+    if (valueType(n->returnType->typeName) != Type::Void) {
+        out << indentation << "fractus::missingReturn(" << quoted(SymbolTable::name(n->name)) << ");\n";
+    }
+    out << "}\n";
+}
+
+/**
+ * Statements
+ */
+
+void CppGenerator::statement(const Node *n) {
+    // call is the only expression used as a statement
+    if (dynamic_cast<const ProcCallNode*>(n)) {
+        out << indentation << expression(n) << ";\n";
+        return;
+    }
+    n->accept(*this);
+}
+
+void CppGenerator::body(const Node *n) {
+    indentation += "    ";
+    statement(n);
+    indentation.resize(indentation.size() - 4);
+}
+
+void CppGenerator::visit(const CompoundNode *n) {
+    for (Node *child : n->children) {
+        statement(child);
+    }
+}
+
+void CppGenerator::visit(const AssignNode *n) {
+    out << indentation << expression(n->left) << " = " << expression(n->right) << ";\n";
+}
+
+void CppGenerator::visit(const IfNode *n) {
+    out << indentation << "if (" << expression(n->condition) << ") {\n";
+    body(n->thenNode);
+    if (n->elseNode) {
+        out << indentation << "} else {\n";
+        body(n->elseNode);
+    }
+    out << indentation << "}\n";
+}
+
+void CppGenerator::visit(const WhileNode *n) {
+    out << indentation << "while (" << expression(n->condition) << ") {\n";
+    body(n->statement);
+    out << indentation << "}\n";
+}
+
+void CppGenerator::visit(const ReturnNode *n) {
+    if (inProcedure) {
+        out << indentation << "return " << expression(n->expr) << ";\n";
+        return;
+    }
+    // return from main program ends it, value is computed and dropped
+    out << indentation << "(void)" << expression(n->expr) << ";\n";
+    out << indentation << "return;\n";
+}
+
+/**
+ * Expressions
+ */
+
+std::string CppGenerator::expression(const Node *n) {
+    n->accept(*this);
+    return result;
+}
+
+bool CppGenerator::ordered(const std::vector<const Node*> &operands) const {
+    // C++ leaves order of evaluation of operands unspecified
+    size_t calling = 0;
+    size_t reading = 0;
+    for (const Node *operand : operands) {
+        DependencyFinder finder(inProcedure);
+        operand->accept(finder);
+        calling += finder.calls;
+        reading += finder.calls || finder.globals;
+    }
+    return calling > 0 && reading > 1;
+}
+
+std::string CppGenerator::constant(const std::string &type, const std::string &initializer) {
+    std::string &name = constantNames[type + " " + initializer];
+    if (name.empty()) {
+        name = "c" + std::to_string(constantNames.size() - 1);
+        constants << "static const " << type << " " << name << "(" << initializer << ");\n";
+    }
+    return name;
+}
+
+void CppGenerator::visit(const NumNode *n) {
+    const ValType &value = n->constant;
+    switch (value.type()) {
+        case Type::Bool:
+            result = value.boolVal() ? "true" : "false";
+            break;
+        case Type::Int:
+            result = intLiteral(value.intVal());
+            break;
+        case Type::String:
+            result = constant("std::string", quoted(value.stringVal()));
+            break;
+        case Type::Fraction:
+            if (value.isSmallFraction()) {
+                Fraction fraction = value.smallFractVal();
+                result = constant("BigFraction", "Fraction(" + intLiteral(fraction.whole) + ", "
+                                                 + intLiteral(fraction.numerator) + ", "
+                                                 + intLiteral(fraction.denominator) + ")");
+            } else {
+                BigFraction fraction = value.fractVal();
+                result = constant("BigFraction", "BigFraction::fromRatio(BigInt::fromString(\""
+                                                 + fraction.improperNumerator().toString()
+                                                 + "\"), BigInt::fromString(\""
+                                                 + fraction.denominator().toString() + "\"))");
+            }
+            break;
+        default:
+            throw std::runtime_error("Unsupported constant in C++ generator");
+    }
+}
+
+void CppGenerator::visit(const VarNode *n) {
+    // local variables hide global ones of the same name, as C++ ones do
+    result = variableName(n->name);
+}
+
+void CppGenerator::visit(const BinOpNode *n) {
+    std::string left = expression(n->left);
+    std::string right = expression(n->right);
+    if (!ordered({n->left, n->right})) {
+        result = operation(n->op, left, right);
+        return;
+    }
+    // left operand is computed first by the lambda, which the compiler inlines
+    result = "[&] { const " + cppType(n->left->type) + " t0 = " + left + "; return "
+             + operation(n->op, "t0", right) + "; }()";
+}
+
+void CppGenerator::visit(const LogicalOp *n) {
+    // && and || are evaluated left to right with short circuit as in the interpreter
+    std::string left = expression(n->left);
+    result = operation(n->op, left, expression(n->right));
+}
+
+void CppGenerator::visit(const UnaryOpNode *n) {
+    result = "(" + std::string(operatorText(n->op)) + expression(n->expression) + ")";
+}
+
+void CppGenerator::visit(const ProcCallNode *n) {
+    if (n->builtin == builtinPrint) {
+        result = "fractus::print(" + expression(n->arguments[0]) + ")";
+        return;
+    }
+    if (n->builtin == builtinRead) {
+        result = "fractus::read(" + expression(n->arguments[0]) + ")";
+        return;
+    }
+
+    std::vector<const Node*> operands(n->arguments.begin(), n->arguments.end());
+    std::vector<std::string> arguments;
+    for (const Node *arg : operands) {
+        arguments.push_back(expression(arg));
+    }
+    std::string call = procedureName(n->proc->name) + "(";
+    if (!ordered(operands)) {
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            call += (i > 0 ? ", " : "") + arguments[i];
+        }
+        result = call + ")";
+        return;
+    }
+    // all arguments but the last one are computed first into temporaries
+    std::string prologue;
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        std::string argument = arguments[i];
+        if (i + 1 < arguments.size()) {
+            std::string temporary = "t" + std::to_string(i);
+            prologue += "const " + cppType(operands[i]->type) + " " + temporary + " = " + argument + "; ";
+            argument = temporary;
+        }
+        call += (i > 0 ? ", " : "") + argument;
+    }
+    result = "[&] { " + prologue + "return " + call + "); }()";
+}
@@ -0,0 +1,72 @@
+//
+// Translator of checked AST to standalone C++ source
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_CPPGENERATOR_H
+#define FRACTUS_CPPGENERATOR_H
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Ast.h"
+
+/**
+ * Tree visitor emitting C++ source of the whole program, which is compiled
+ * ahead of time with CppRuntime.h and the core library.
+ * Procedures become functions (nested ones are moved out, only their own
+ * and global variables are reachable anyway), global variables become statics
+ * and values have their static types: int, bool, std::string and BigFraction.
+ * Operands are evaluated left to right, as in the interpreter.
+ * Expects AST already checked by SemanticAnalyzer.
+ */
+class CppGenerator : public Visitor {
+public:
+    CppGenerator();
+
+    std::string generate(const ProgramNode *ast);
+
+    void visit(const BinOpNode *n);
+    void visit(const LogicalOp *n);
+    void visit(const NumNode *n);
+    void visit(const UnaryOpNode *n);
+    void visit(const CompoundNode *n);
+    void visit(const AssignNode *n);
+    void visit(const IfNode *n);
+    void visit(const WhileNode *n);
+    void visit(const ReturnNode *n);
+    void visit(const VarNode *n);
+    void visit(const ProgramNode *n) {}
+    void visit(const BlockNode *n) {}
+    void visit(const VarDeclNode *n);
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n);
+    void visit(const ProcCallNode *n);
+
+private:
+    void collectProcedures(const BlockNode *block);
+    std::string signature(const ProcDeclNode *n) const;
+
+    // C++ expression computing value of n
+    std::string expression(const Node *n);
+    void statement(const Node *n);
+    // statement in braces of if or while
+    void body(const Node *n);
+    // true when a call in one of operands can change what another one reads
+    bool ordered(const std::vector<const Node*> &operands) const;
+    // name of constant defined once for the whole program
+    std::string constant(const std::string &type, const std::string &initializer);
+
+    std::ostringstream out;       // variables and procedures
+    std::ostringstream constants; // definitions of hoisted literals
+    std::map<std::string, std::string> constantNames; // by type and initializer
+    std::vector<const ProcDeclNode*> procedures;
+    std::string indentation;
+    std::string result;           // expression of the last visited node
+    bool inProcedure;
+};
+
+#endif //FRACTUS_CPPGENERATOR_H
@@ -0,0 +1,76 @@
+//
+// Runtime support of C++ programs generated from FraCtuS sources
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_CPPRUNTIME_H
+#define FRACTUS_CPPRUNTIME_H
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "BigFraction.h"
+#include "Numeric.h"
+
+/**
+ * Builtin procedures and checked operations called by code of CppGenerator.
+ * Output and error messages are the same as those of the interpreter.
+ * Generated names have prefixes, so the namespace keeps these apart only
+ * from the standard library.
+ */
+namespace fractus {
+
+inline int divide(int left, int right) {
+    if (right == 0) {
+        throw std::runtime_error("Operand must be different than 0.");
+    }
+    return wrappingDivide(left, right);
+}
+
+inline BigFraction divide(const BigFraction &left, const BigFraction &right) {
+    if (right.isZero()) {
+        throw std::runtime_error("Operand must be different than 0.");
+    }
+    return left / right;
+}
+
+// cout is tied to cin, so output is flushed before every read anyway
+inline void print(int value) {
+    std::cout << value << '\n';
+}
+
+inline void print(bool value) {
+    std::cout << (value ? "true" : "false") << '\n';
+}
+
+inline void print(const std::string &value) {
+    std::cout << value << '\n';
+}
+
+inline void print(const BigFraction &value) {
+    std::cout << value << '\n';
+}
+
+// same stream operators as the interpreter uses for values of each type
+template <typename T>
+void read(T &variable) {
+    std::cin >> variable;
+}
+
+[[noreturn]] inline void missingReturn(const char *procName) {
+    throw std::runtime_error(std::string("Procedure ") + procName + " ended without returning a value.");
+}
+
+inline int run(void (*program)()) {
+    try {
+        program();
+    } catch (const std::runtime_error &e) {
+        std::cout << "Runtime error: " << e.what() << std::endl;
+    }
+    return 0;
+}
+
+}
+
+#endif //FRACTUS_CPPRUNTIME_H
@@ -3,7 +3,61 @@
 // Wiktor Franus, WUT 2017
 //
 
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+
 #include "Fraction.h"
+#include "Numeric.h"
+
+// intermediate results which do not fit in 64 bits
+using WideInt = __int128;
+
+static void overflowError() {
+    throw std::runtime_error("Fraction overflow: result does not fit in integer parts");
+}
+
+// canonical fraction equal to num / den (den != 0), false if it does not fit
+static bool reduce(int64_t num, int64_t den, Fraction &result) {
+    if (den < 0) {
+        if (__builtin_sub_overflow(0, num, &num) || __builtin_sub_overflow(0, den, &den)) {
+            return false;
+        }
+    }
+    uint64_t g = greatestCommonDivisor(absoluteValue(num), static_cast<uint64_t>(den));
+    if (g > 1) {
+        num /= static_cast<int64_t>(g);
+        den /= static_cast<int64_t>(g);
+    }
+
+    // truncating division leaves remainder with the sign of whole part
+    int64_t whole = num / den;
+    if (whole < INT_MIN || whole > INT_MAX || den > INT_MAX) {
+        return false;
+    }
+    result.whole = static_cast<int>(whole);
+    result.numerator = static_cast<int>(num % den);
+    result.denominator = static_cast<int>(den);
+    return true;
+}
+
+// reduce 128-bit ratio, then continue on machine words
+static bool reduceWide(WideInt num, WideInt den, Fraction &result) {
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+    unsigned __int128 absNum = num < 0 ? -static_cast<unsigned __int128>(num) : num;
+    unsigned __int128 g = greatestCommonDivisor(absNum, static_cast<unsigned __int128>(den));
+    if (g > 1) {
+        num /= static_cast<WideInt>(g);
+        den /= static_cast<WideInt>(g);
+    }
+    if (num < INT64_MIN || num > INT64_MAX || den > INT64_MAX) {
+        return false;
+    }
+    return reduce(static_cast<int64_t>(num), static_cast<int64_t>(den), result);
+}
 
 Fraction::Fraction()
 : whole(0)
@@ -11,13 +65,33 @@ Fraction::Fraction()
 , denominator(1)
 {}
 
-Fraction::~Fraction() {}
+Fraction::Fraction(int whole, int numerator, int denominator) {
+    if (denominator == 0) {
+        throw std::runtime_error("Denominator has to be different than 0!");
+    }
+    // int parts cannot overflow 64 bits
+    *this = fromRatio(static_cast<int64_t>(whole) * denominator + numerator, denominator);
+}
+
+Fraction Fraction::fromRatio(int64_t num, int64_t den) {
+    if (den == 0) {
+        throw std::runtime_error("Denominator has to be different than 0!");
+    }
+    Fraction f;
+    if (!reduce(num, den, f)) {
+        overflowError();
+    }
+    return f;
+}
 
 std::ostream& operator<<(std::ostream& os, const Fraction& obj) {
     if (obj.whole) {
-        os << obj.whole << ".";
+        // sign is printed once, with the whole part
+        os << obj.whole << "." << std::abs(obj.numerator);
+    } else {
+        os << obj.numerator;
     }
-    os << obj.numerator << "_" << obj.denominator;
+    os << "_" << obj.denominator;
     return os;
 }
 
@@ -25,28 +99,58 @@ std::istream& operator>>(std::istream& in, Fraction& obj) {
     std::string s;
     size_t periodPos, sepPos;
     in >> s;
-    if ((periodPos = s.find('.')) != std::string::npos) {
-        obj.whole = stoi(s.substr(0, periodPos));
-    }
-    if ((sepPos = s.find('_')) != std::string::npos) {
-        if (periodPos == std::string::npos) {
-            obj.numerator = stoi(s.substr(0, sepPos));
-        } else {
-            obj.numerator = stoi(s.substr(periodPos + 1, sepPos - periodPos - 1));
+    periodPos = s.find('.');
+    sepPos = s.find('_');
+    if (periodPos == std::string::npos && sepPos == std::string::npos) {
+        return in;
+    }
+
+    int whole = 0, numerator = 0, denominator = 1;
+    try {
+        if (periodPos != std::string::npos) {
+            whole = stoi(s.substr(0, periodPos));
+        }
+        if (sepPos != std::string::npos) {
+            if (periodPos == std::string::npos) {
+                numerator = stoi(s.substr(0, sepPos));
+            } else {
+                numerator = stoi(s.substr(periodPos + 1, sepPos - periodPos - 1));
+            }
+            denominator = stoi(s.substr(sepPos + 1, s.length() - sepPos - 1));
         }
-        obj.denominator = stoi(s.substr(sepPos + 1, s.length() - sepPos - 1));
+    } catch (const std::logic_error &e) {
+        throw std::runtime_error("Invalid fraction: " + s);
     }
+
+    // in mixed number notation "-1.1_2" minus applies to fraction part too
+    if (periodPos != std::string::npos && s[0] == '-') {
+        numerator = -std::abs(numerator);
+    }
+    obj = Fraction(whole, numerator, denominator);
     return in;
 }
 
-bool operator==(const Fraction &left, const Fraction &right) {
-    Fraction l = left;
-    Fraction r = right;
+// sign of left - right
+static int compare(const Fraction &left, const Fraction &right) {
+    int64_t l = left.improperNumerator();
+    int64_t r = right.improperNumerator();
+    // equal denominators (incl. whole numbers) need no scaling
+    if (left.denominator != right.denominator) {
+        if (__builtin_mul_overflow(l, right.denominator, &l)
+            || __builtin_mul_overflow(r, left.denominator, &r)) {
+            WideInt wl = static_cast<WideInt>(left.improperNumerator()) * right.denominator;
+            WideInt wr = static_cast<WideInt>(right.improperNumerator()) * left.denominator;
+            return (wl > wr) - (wl < wr);
+        }
+    }
+    return (l > r) - (l < r);
+}
 
-    convertToCommonDenominator(l,r);
-    if (l.whole) l.numerator = l.whole * l.numerator;
-    if (r.whole) r.numerator = r.whole * r.numerator;
-    return l.numerator == r.numerator;
+bool operator==(const Fraction &left, const Fraction &right) {
+    // canonical form is unique
+    return left.whole == right.whole
+           && left.numerator == right.numerator
+           && left.denominator == right.denominator;
 }
 
 bool operator!=(const Fraction &left, const Fraction &right) {
@@ -54,23 +158,11 @@ bool operator!=(const Fraction &left, const Fraction &right) {
 }
 
 bool operator<(const Fraction &left, const Fraction &right) {
-    Fraction l = left;
-    Fraction r = right;
-
-    convertToCommonDenominator(l,r);
-    if (l.whole) l.numerator = l.whole * l.numerator;
-    if (r.whole) r.numerator = r.whole * r.numerator;
-    return l.numerator < r.numerator;
+    return compare(left, right) < 0;
 }
 
 bool operator>(const Fraction &left, const Fraction &right) {
-    Fraction l = left;
-    Fraction r = right;
-
-    convertToCommonDenominator(l,r);
-    if (l.whole) l.numerator = l.whole * l.numerator;
-    if (r.whole) r.numerator = r.whole * r.numerator;
-    return l.numerator > r.numerator;
+    return compare(left, right) > 0;
 }
 
 bool operator<=(const Fraction &left, const Fraction &right) {
@@ -78,72 +170,98 @@ bool operator<=(const Fraction &left, const Fraction &right) {
 }
 
 bool operator>=(const Fraction &left, const Fraction &right) {
-    return !(right < left);
+    return !(right > left);
 }
 
-Fraction operator+(const Fraction &left, const Fraction &right) {
-    Fraction l = left;
-    Fraction r = right;
-    Fraction ret;
+Fraction operator-(const Fraction &operand) {
+    return Fraction::fromRatio(-operand.improperNumerator(), operand.denominator);
+}
 
-    convertToCommonDenominator(l,r);
-    ret.whole = l.whole + r.whole;
-    ret.numerator = l.numerator + r.numerator;
-    ret.denominator = l.denominator;
-    return ret;
+// l / ld + sign * r / rd
+static bool add(int64_t l, int64_t ld, int64_t r, int64_t rd, int sign, Fraction &result) {
+    int64_t den = leastCommonMultiple(ld, rd);
+    int64_t lFactor = den / ld;
+    int64_t rFactor = den / rd * sign;
+    int64_t a, b, num;
+    if (__builtin_mul_overflow(l, lFactor, &a)
+        || __builtin_mul_overflow(r, rFactor, &b)
+        || __builtin_add_overflow(a, b, &num)) {
+        return reduceWide(static_cast<WideInt>(l) * lFactor + static_cast<WideInt>(r) * rFactor, den, result);
+    }
+    return reduce(num, den, result);
 }
 
-Fraction operator-(const Fraction &left, const Fraction &right) {
-    Fraction l = left;
-    Fraction r = right;
-    Fraction ret;
+// (l / ld) * (r / rd)
+static bool multiply(int64_t l, int64_t ld, int64_t r, int64_t rd, Fraction &result) {
+    // cross reduction keeps operands small
+    int64_t g = static_cast<int64_t>(greatestCommonDivisor(absoluteValue(l), absoluteValue(rd)));
+    if (g > 1) {
+        l /= g;
+        rd /= g;
+    }
+    g = static_cast<int64_t>(greatestCommonDivisor(absoluteValue(r), absoluteValue(ld)));
+    if (g > 1) {
+        r /= g;
+        ld /= g;
+    }
+    int64_t num, den;
+    if (__builtin_mul_overflow(l, r, &num) || __builtin_mul_overflow(ld, rd, &den)) {
+        return reduceWide(static_cast<WideInt>(l) * r, static_cast<WideInt>(ld) * rd, result);
+    }
+    return reduce(num, den, result);
+}
 
-    convertToCommonDenominator(l,r);
-    ret.whole = l.whole - r.whole;
-    ret.numerator = l.numerator - r.numerator;
-    ret.denominator = l.denominator;
-    return ret;
+bool checkedAdd(const Fraction &left, const Fraction &right, Fraction &result) {
+    return add(left.improperNumerator(), left.denominator,
+               right.improperNumerator(), right.denominator, 1, result);
 }
 
-Fraction operator*(const Fraction &left, const Fraction &right) {
-    Fraction ret;
-    ret.whole = 0;
-    ret.numerator = left.whole ? (left.whole * left.denominator) + left.numerator : left.numerator;
-    ret.numerator *= right.whole ? (right.whole * right.denominator) + right.numerator : right.numerator;
-    ret.denominator = left.denominator * right.denominator;
-    return ret;
+bool checkedSubtract(const Fraction &left, const Fraction &right, Fraction &result) {
+    return add(left.improperNumerator(), left.denominator,
+               right.improperNumerator(), right.denominator, -1, result);
 }
 
-Fraction operator/(const Fraction &left, const Fraction &right) {
-    Fraction r = right;
-    Fraction ret;
-    ret.whole = 0;
-    ret.numerator = left.whole ? (left.whole * left.denominator) + left.numerator : left.numerator;
-    r.numerator = right.denominator;
-    r.denominator = right.whole ? (right.whole * right.denominator) + right.numerator : right.numerator;
-    ret.numerator *= r.numerator;
-    ret.denominator = left.denominator * r.denominator;
-    return ret;
+bool checkedMultiply(const Fraction &left, const Fraction &right, Fraction &result) {
+    return multiply(left.improperNumerator(), left.denominator,
+                    right.improperNumerator(), right.denominator, result);
+}
+
+bool checkedDivide(const Fraction &left, const Fraction &right, Fraction &result) {
+    return multiply(left.improperNumerator(), left.denominator,
+                    right.denominator, right.improperNumerator(), result);
 }
 
-void convertToCommonDenominator(Fraction &l, Fraction &r) {
-    if (l.denominator != r.denominator) {
-        int mcm = mostCommonMultiple(l.denominator, r.denominator);
-        l.numerator = (l.numerator * mcm) / l.denominator;
-        r.numerator = (r.numerator * mcm) / r.denominator;
-        l.denominator = r.denominator = mcm;
+Fraction operator+(const Fraction &left, const Fraction &right) {
+    Fraction result;
+    if (!checkedAdd(left, right, result)) {
+        overflowError();
     }
+    return result;
 }
 
-int mostCommonMultiple(int a, int b) {
-    int m = a*b;
+Fraction operator-(const Fraction &left, const Fraction &right) {
+    Fraction result;
+    if (!checkedSubtract(left, right, result)) {
+        overflowError();
+    }
+    return result;
+}
 
-    do
-    {
-        if(a>b) a=a-b;
-        else b=b-a;
+Fraction operator*(const Fraction &left, const Fraction &right) {
+    Fraction result;
+    if (!checkedMultiply(left, right, result)) {
+        overflowError();
     }
-    while(a!=b);
+    return result;
+}
 
-    return m/a;
+Fraction operator/(const Fraction &left, const Fraction &right) {
+    if (right.isZero()) {
+        throw std::runtime_error("Division by zero fraction.");
+    }
+    Fraction result;
+    if (!checkedDivide(left, right, result)) {
+        overflowError();
+    }
+    return result;
 }
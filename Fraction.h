@@ -6,11 +6,15 @@
 #ifndef FRACTUS_FRACTION_H
 #define FRACTUS_FRACTION_H
 
+#include <cstdint>
 #include <iostream>
 #include <utility>
 
 /**
- * Representation of mixed number (whole + fraction)
+ * Representation of mixed number (whole + fraction).
+ * Value is whole + numerator / denominator, always kept in canonical form:
+ * denominator > 0, |numerator| < denominator, numerator and denominator
+ * are coprime and numerator has the same sign as whole part.
  */
 class Fraction {
 public:
@@ -19,7 +23,18 @@ public:
     int denominator;
 
     Fraction();
-    ~Fraction();
+    Fraction(int whole, int numerator, int denominator);
+
+    // value as improper fraction numerator (over denominator)
+    int64_t improperNumerator() const {
+        return static_cast<int64_t>(whole) * denominator + numerator;
+    }
+    bool isZero() const {
+        return whole == 0 && numerator == 0;
+    }
+
+    // canonical fraction equal to num / den, throws if it does not fit
+    static Fraction fromRatio(int64_t num, int64_t den);
 
     friend std::ostream& operator<<(std::ostream& os, const Fraction& obj);
     friend std::istream& operator>>(std::istream& in, Fraction& obj);
@@ -31,12 +46,17 @@ bool operator<(const Fraction &left, const Fraction &right);
 bool operator>(const Fraction &left, const Fraction &right);
 bool operator<=(const Fraction &left, const Fraction &right);
 bool operator>=(const Fraction &left, const Fraction &right);
+Fraction operator-(const Fraction &operand);
 Fraction operator+(const Fraction &left, const Fraction &right);
 Fraction operator-(const Fraction &left, const Fraction &right);
 Fraction operator*(const Fraction &left, const Fraction &right);
 Fraction operator/(const Fraction &left, const Fraction &right);
 
-void convertToCommonDenominator(Fraction &l, Fraction &r);
-int mostCommonMultiple(int a, int b);
+// arithmetic without exceptions, false if result does not fit in Fraction
+// (divisor of checkedDivide has to be different than 0)
+bool checkedAdd(const Fraction &left, const Fraction &right, Fraction &result);
+bool checkedSubtract(const Fraction &left, const Fraction &right, Fraction &result);
+bool checkedMultiply(const Fraction &left, const Fraction &right, Fraction &result);
+bool checkedDivide(const Fraction &left, const Fraction &right, Fraction &result);
 
 #endif //FRACTUS_FRACTION_H
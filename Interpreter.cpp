@@ -3,91 +3,244 @@
 // Wiktor Franus, WUT 2017
 //
 
+#include <algorithm>
+
 #include "Interpreter.h"
+#include "Compiler.h"
+#include "VM.h"
+#include "RegisterCompiler.h"
+#include "RegisterVM.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// initial sizes of tree walker's stacks, both grow twice when they are full
+static const size_t INITIAL_STACK = 4096;
+static const size_t INITIAL_FRAMES = 256;
+// native stack left for evaluation inside the deepest call
+static const size_t NATIVE_STACK_RESERVE = 256 << 10;
+static const size_t DEFAULT_NATIVE_STACK = 8 << 20;
+
+static size_t nativeStackSize() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        return static_cast<size_t>(limit.rlim_cur);
+    }
+#endif
+    return DEFAULT_NATIVE_STACK;
+}
 
-Interpreter::Interpreter(Prototypes *prototypes, ProgramNode *ast)
-: scopes(prototypes)
-, procedures(ast->block->procDeclarations)
+Interpreter::Interpreter(Prototypes *prototypes, ProgramNode *ast, ExecutionMode mode,
+                         size_t stackMemory, size_t memoEntries)
+: mode(mode)
+, stackMemory(stackMemory)
+, scopes(prototypes)
 , ast(ast)
-, globalContext(nullptr)
+, stackTop(nullptr)
+, nativeStackLimit(0)
+, tailCallee(nullptr)
+, memo(memoEntries > 0 ? new MemoCache(memoEntries) : nullptr)
 {}
 
 void Interpreter::interpret() {
     if (scopes && ast) {
-        createNewContextFrame("global");
         try {
-            ast->evaluate(this);
+            if (mode == ExecutionMode::Bytecode) {
+                runBytecode();
+            } else if (mode == ExecutionMode::Registers || mode == ExecutionMode::Jit) {
+                runRegisters();
+            } else {
+                valueStack.resize(INITIAL_STACK);
+                stackTop = valueStack.data();
+                frames.reserve(INITIAL_FRAMES);
+                // calls recurse natively from here, until only NATIVE_STACK_RESERVE is left
+                char base;
+                uintptr_t top = reinterpret_cast<uintptr_t>(&base);
+                size_t available = nativeStackSize();
+                available = available > NATIVE_STACK_RESERVE ? available - NATIVE_STACK_RESERVE : 0;
+                nativeStackLimit = top - std::min<uintptr_t>(available, top);
+                createNewContextFrame(scopes->front());
+                ast->execute(this);
+            }
         } catch (std::runtime_error e) {
             std::cout<< "Runtime error: " << e.what() << std::endl;
         }
+        if (memo) {
+            // kept apart from output of the program
+            std::cerr << "Memoized calls: " << memo->getHits() << " hits, "
+                      << memo->getMisses() << " misses" << std::endl;
+        }
     }
 }
 
-void Interpreter::createNewContextFrame(const std::string &procName) {
-    Scope *procScope = nullptr;
-    try {
-        procScope = scopes->at(procName);
-    } catch (std::out_of_range e) {
-        throw std::runtime_error("Cannot find declared procedure: " + procName);
+void Interpreter::runBytecode() {
+    Compiler compiler(scopes);
+    CompiledProgram program = compiler.compile(ast);
+    VM vm(this, program, stackMemory);
+    vm.run();
+}
+
+void Interpreter::runRegisters() {
+    RegisterCompiler compiler(scopes);
+    RegProgram program = compiler.compile(ast);
+    RegisterVM vm(this, program, stackMemory, mode == ExecutionMode::Jit);
+    vm.run();
+}
+
+bool Interpreter::fits(size_t stackSize, size_t frameCount) const {
+    return stackSize * sizeof(ValType) + frameCount * sizeof(Context) <= stackMemory;
+}
+
+void Interpreter::reserve(size_t required, const std::string &error) {
+    size_t used = static_cast<size_t>(stackTop - valueStack.data());
+    size_t stackSize = valueStack.size() < required ? std::max(valueStack.size() * 2, required) : valueStack.size();
+    size_t frameCount = frames.size() < frames.capacity() ? frames.capacity() : frames.capacity() * 2;
+    if (!fits(stackSize, frameCount)) {
+        // close to the limit both are scaled down together to the largest
+        // size fitting the limit, so they grow once more, not per call
+        size_t stackNeeded = std::max(valueStack.size(), required);
+        size_t frameNeeded = std::max(frames.capacity(), frames.size() + 1);
+        if (!fits(stackNeeded, frameNeeded)) {
+            throw std::runtime_error(error);
+        }
+        // binary search of the part of doubled growth that fits
+        size_t low = 0, high = 1024;
+        auto scaled = [](size_t needed, size_t doubled, size_t part) {
+            return needed + (doubled - needed) * part / 1024;
+        };
+        while (low < high) {
+            size_t part = (low + high + 1) / 2;
+            if (fits(scaled(stackNeeded, stackSize, part), scaled(frameNeeded, frameCount, part))) {
+                low = part;
+            } else {
+                high = part - 1;
+            }
+        }
+        stackSize = scaled(stackNeeded, stackSize, low);
+        frameCount = scaled(frameNeeded, frameCount, low);
     }
 
-    if (!globalContext) {
-        Context runtimeContext(procScope, nullptr); // variable initialization inside Context c-tor
-        contextStack.push(std::move(runtimeContext));
-        globalContext = &contextStack.top();
+    ValType *oldBase = valueStack.data();
+    if (stackSize > valueStack.size()) {
+        std::vector<ValType> grown(stackSize);
+        std::move(valueStack.begin(), valueStack.begin() + used, grown.begin());
+        valueStack.swap(grown);
+        stackTop = valueStack.data() + used;
+    }
+    frames.reserve(frameCount);
+    // frames keep pointers into the value stack and to the global frame
+    for (size_t i = 0; i < frames.size(); ++i) {
+        frames[i].relocate(valueStack.data() + (frames[i].getSlots() - oldBase), i > 0 ? &frames.front() : nullptr);
+    }
+}
 
-    } else {
-        Context runtimeContext(procScope, globalContext); // variable initialization inside Context c-tor
-        contextStack.push(std::move(runtimeContext));
+void Interpreter::pushArgument(const ValType &value) {
+    if (stackTop == valueStack.data() + valueStack.size()) {
+        reserve(valueStack.size() + 1, "Stack overflow.");
     }
+    *stackTop++ = value;
 }
 
-void Interpreter::popContextFrame() {
-    contextStack.pop();
+void Interpreter::createNewContextFrame(Scope *procScope, size_t argCount) {
+    const std::vector<ValType> &layout = procScope->getFrameLayout();
+    char marker;
+    if (reinterpret_cast<uintptr_t>(&marker) < nativeStackLimit) {
+        throw std::runtime_error("Stack overflow in procedure: " + SymbolTable::name(procScope->getScopeName()));
+    }
+    if (frames.size() == frames.capacity()
+        || stackTop - argCount + layout.size() > valueStack.data() + valueStack.size()) {
+        size_t base = static_cast<size_t>(stackTop - argCount - valueStack.data());
+        reserve(base + layout.size(), "Stack overflow in procedure: " + SymbolTable::name(procScope->getScopeName()));
+    }
+    ValType *slots = stackTop - argCount;
+
+    // pushed arguments become parameters
+    std::copy(layout.begin() + argCount, layout.end(), slots + argCount);
+    stackTop = slots + layout.size();
+
+    Context *globalContext = frames.empty() ? nullptr : &frames.front();
+    frames.emplace_back(procScope, slots, globalContext);
 }
 
+void Interpreter::replaceContextFrame(const ProcDescriptor *callee, size_t argCount) {
+    const std::vector<ValType> &layout = callee->scope->getFrameLayout();
+    if (frames.back().getSlots() + layout.size() > valueStack.data() + valueStack.size()) {
+        size_t base = static_cast<size_t>(frames.back().getSlots() - valueStack.data());
+        reserve(base + layout.size(), "Stack overflow in procedure: " + SymbolTable::name(callee->name));
+    }
+    ValType *slots = frames.back().getSlots();
+
+    // arguments lie above the frame, so they can be moved down in order
+    std::move(stackTop - argCount, stackTop, slots);
+    std::copy(layout.begin() + argCount, layout.end(), slots + argCount);
+    stackTop = slots + layout.size();
 
+    frames.back() = Context(callee->scope, slots, &frames.front());
+    tailCallee = callee;
+}
 
-void Interpreter::checkNumberOperand(const ValType &operand) {
-    if (operand.second == Type::Int || operand.second == Type::Fraction) {
-        return;
+void Interpreter::popContextFrame() {
+    stackTop = frames.back().getSlots();
+    frames.pop_back();
+}
+
+ValType Interpreter::binaryOperation(Token op, const ValType &leftRes, const ValType &rightRes) {
+    switch (op) {
+        case PLUS:
+            return leftRes + rightRes;
+        case MINUS:
+            return leftRes - rightRes;
+        case MULTSIGN:
+            return leftRes * rightRes;
+        case DIVSIGN:
+            checkDifferentThanZero(rightRes);
+            return leftRes / rightRes;
+        case EQOP:
+            return ValType::fromBool(leftRes == rightRes);
+        case NEQOP:
+            return ValType::fromBool(leftRes != rightRes);
+        case LTOP:
+            return ValType::fromBool(leftRes < rightRes);
+        case LEOP:
+            return ValType::fromBool(leftRes <= rightRes);
+        case GTOP:
+            return ValType::fromBool(leftRes > rightRes);
+        case GEOP:
+            return ValType::fromBool(leftRes >= rightRes);
+        default:
+            break;
     }
-    throw std::runtime_error("Operand must be a number.");
+    return ValType(); //should not happen
 }
 
-void Interpreter::checkNumberOperands(const ValType &left, const ValType &right) {
-    if ((left.second == Type::Int || left.second == Type::Fraction)
-        && (right.second == Type::Int || right.second == Type::Fraction)) {
-        return;
+ValType Interpreter::unaryOperation(Token op, ValType expRes) {
+    switch (op) {
+        case MINUS:
+            if (expRes.type() == Type::Int) {
+                return ValType::fromInt(-expRes.intVal());
+            }
+            return ValType::fromFraction(-expRes.fractVal());
+        case NOTSIGN:
+            return ValType::fromBool(!expRes.boolVal());
+        default:
+            break;
     }
-    throw std::runtime_error("Operands must be numbers.");
+    return ValType(); //should not happen
 }
 
 void Interpreter::checkDifferentThanZero(const ValType &operand) {
-    if ((operand.second == Type::Int && operand.first.intVal != 0)
-        || (operand.second == Type::Fraction || operand.first.fractVal.numerator != 0)) {
+    if ((operand.type() == Type::Int && operand.intVal() != 0)
+        || (operand.type() == Type::Fraction && !operand.fractVal().isZero())) {
         return;
     }
     throw std::runtime_error("Operand must be different than 0.");
 }
 
-Context &Interpreter::currContext() {
-    return contextStack.top();
-}
-
-ProcDeclNode *Interpreter::getProcNodes(const std::string &name) {
-    auto it = std::find_if(procedures.begin(), procedures.end(),
-                           [&](const ProcDeclNode *p) { return p->name == name; }
-    );
-    if (it != procedures.end()) {
-        return *it;
+void Interpreter::checkCompletion(Completion completion, Type declared, const std::string &procName) {
+    // the only case not ruled out statically: end of procedure reached without return
+    if (completion != Completion::Return && declared != Type::Void) {
+        throw std::runtime_error("Procedure " + procName + " ended without returning a value.");
     }
-    return nullptr;
-}
-
-bool Interpreter::isTruthy(const ValType &v) {
-    if (v.second == Type::Void) return false;
-    if (v.second == Type::Bool) return v.first.boolVal;
-    return true;
 }
-
@@ -6,44 +6,91 @@
 #ifndef FRACTUS_INTEPRETER_H
 #define FRACTUS_INTEPRETER_H
 
-#include <stack>
-#include <algorithm>
+#include <cstdint>
+#include <memory>
 
 #include "Ast.h"
+#include "MemoCache.h"
+
+/**
+ * Execution strategy used by the interpreter
+ */
+enum class ExecutionMode {
+    TreeWalking,    // evaluate AST nodes directly
+    Adaptive,       // as TreeWalking, nodes specialize themselves while running
+    Bytecode,       // compile to bytecode and run on stack VM
+    Registers,      // compile to register code and run on register VM
+    Jit             // as Registers, hot code compiled to machine code
+};
 
 /**
  * FraCtuS language interpreter (tree evaluator)
  */
 class Interpreter /*: public Visitor*/ {
 public:
-    using Prototypes = std::map<std::string, Scope*>;
+    using Prototypes = std::vector<Scope*>; // global scope first, then procedure scopes
 
-    std::map<Type, std::string> typeNames = {
-            {Type::Bool, "boolean"},
-            {Type::Int, "integer"},
-            {Type::String, "string"},
-            {Type::Fraction, "fraction"},
-            {Type::Void, "void"}
-    };
+    // memory for value stack and frames, nested calls of the tree walker are limited by native stack too
+    static const size_t DEFAULT_STACK_MEMORY = 64 << 20;
+    // results of pure procedures kept with --memo
+    static const size_t DEFAULT_MEMO_ENTRIES = 1 << 16;
 
-    Interpreter(Prototypes *prototypes, ProgramNode *ast);
+    Interpreter(Prototypes *prototypes, ProgramNode *ast,
+                ExecutionMode mode = ExecutionMode::TreeWalking,
+                size_t stackMemory = DEFAULT_STACK_MEMORY,
+                size_t memoEntries = 0);
     void interpret();
-    Context &currContext();
-    ProcDeclNode *getProcNodes(const std::string &name);
-    void createNewContextFrame(const std::string &procName);
+    Context &currContext() {
+        return frames.back();
+    }
+    // variables of the main program, in the first frame
+    ValType *globalSlots() {
+        return frames.front().getSlots();
+    }
+    void pushArgument(const ValType &value);
+    // values pushed by pushArgument, not taken by a frame yet
+    const ValType *pushedArguments(size_t count) const {
+        return stackTop - count;
+    }
+    void dropArguments(size_t count) {
+        stackTop -= count;
+    }
+    void createNewContextFrame(Scope *procScope, size_t argCount = 0);
     void popContextFrame();
+    // callee of tail call takes over the current frame, its arguments are pushed above it
+    void replaceContextFrame(const ProcDescriptor *callee, size_t argCount);
+    const ProcDescriptor *getTailCallee() const {
+        return tailCallee;
+    }
+    // results of pure procedures, null when memoization is off
+    MemoCache *getMemo() const {
+        return memo.get();
+    }
+
 
+    // operands are already type checked by SemanticAnalyzer
+    static ValType binaryOperation(Token op, const ValType &left, const ValType &right);
+    static ValType unaryOperation(Token op, ValType operand);
 
-    bool isTruthy(const ValType &v);
-    void checkNumberOperand(const ValType &operand);
-    void checkNumberOperands(const ValType &left, const ValType &right);
-    void checkDifferentThanZero(const ValType &operand);
+    static void checkDifferentThanZero(const ValType &operand);
+    void checkCompletion(Completion completion, Type declared, const std::string &procName);
 private:
+    void runBytecode();
+    void runRegisters();
+    // grows value stack to at least required values and frames for one more call, within stackMemory
+    void reserve(size_t required, const std::string &error);
+    bool fits(size_t stackSize, size_t frameCount) const;
+
+    ExecutionMode mode;
+    size_t stackMemory;
     Prototypes *scopes;
-    std::vector<ProcDeclNode*> &procedures;
     ProgramNode *ast;
-    Context *globalContext;
-    std::stack<Context> contextStack;
+    std::vector<ValType> valueStack; // variables of all frames
+    ValType *stackTop;
+    std::vector<Context> frames;
+    uintptr_t nativeStackLimit;      // lowest address of native stack a call may start at
+    const ProcDescriptor *tailCallee; // procedure replacing the current one in its frame
+    std::unique_ptr<MemoCache> memo;
 };
 
 
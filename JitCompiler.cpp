@@ -0,0 +1,463 @@
+//
+// JitCompiler source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <cstddef>
+#include <cstring>
+
+#include "JitCompiler.h"
+#include "Assembler.h"
+
+// where JIT is supported, see JitCompiler.h
+#ifdef FRACTUS_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Native code keeps registers of the running frame where the VM keeps them,
+ * in the integer bank: register r is at [rbx + 4r]. Other machine registers:
+ * r12 - NativeContext, r13 - global registers, rbp - callee, r14 - its frame.
+ * Function: push callee-saved registers, jump to entry (or fall to the first
+ * instruction when it is null), return NativeStatus in eax.
+ */
+
+static const Reg REGS = Reg::RBX;
+static const Reg CONTEXT = Reg::R12;
+static const Reg GLOBALS = Reg::R13;
+static const Reg CALLEE = Reg::RBP;
+static const Reg CALLEE_REGS = Reg::R14;
+
+static const int32_t DEPTH = offsetof(NativeContext, depth);
+static const int32_t RESULT = offsetof(NativeContext, result);
+static const int32_t INTS_END = offsetof(NativeContext, intsEnd);
+static const int32_t ENTRIES = offsetof(NativeContext, entries);
+
+static const uint32_t NO_RESULT = static_cast<uint32_t>(-1);
+
+static int32_t slot(size_t reg) {
+    return static_cast<int32_t>(reg * sizeof(int32_t));
+}
+
+static int32_t entryField(size_t index, size_t field) {
+    return static_cast<int32_t>(index * sizeof(NativeContext::Entry) + field);
+}
+
+// EqualI..GreaterEqualI and JumpIfEqualI..JumpIfGreaterEqualI are in the same order
+static Cond condition(RegOp op, RegOp first) {
+    static const Cond conditions[] = {Cond::Equal, Cond::NotEqual, Cond::Less,
+                                      Cond::LessEqual, Cond::Greater, Cond::GreaterEqual};
+    return conditions[static_cast<int>(op) - static_cast<int>(first)];
+}
+
+static bool isBranch(RegOp op) {
+    return op >= RegOp::Jump && op <= RegOp::JumpIfGreaterEqualI;
+}
+
+// registers of callee's frame set to its image, except parameters
+static void initialize(Assembler &as, Reg frame, const RegProcedure &callee) {
+    static const size_t UNROLLED_MAX = 32;
+    if (callee.ints.size() > UNROLLED_MAX) {
+        as.move64(Reg::RSI, reinterpret_cast<uint64_t>(callee.ints.data()));
+        as.move64(Reg::RDI, frame);
+        as.move32(Reg::RCX, static_cast<int32_t>(callee.ints.size()));
+        as.repMovsd();
+        return;
+    }
+    std::vector<bool> param(callee.ints.size(), false);
+    for (const RegProcedure::Param &p : callee.params) {
+        param[p.reg] = true;
+    }
+    for (size_t reg = 0; reg < callee.ints.size(); ++reg) {
+        if (!param[reg]) {
+            as.store32(frame, slot(reg), callee.ints[reg]);
+        }
+    }
+}
+
+JitCompiler::JitCompiler(const RegProgram &program, bool memo)
+: program(program)
+, memo(memo)
+, procedures(program.procedures.size() + 1)
+, entries(program.procedures.size() + 1, NativeContext::Entry{nullptr, nullptr})
+{
+    context.globals = nullptr;
+    context.intsEnd = nullptr;
+    context.entries = entries.data();
+    context.depth = 0;
+    context.result = 0;
+    context.exits = &exits;
+    // native code records where it stopped without allocating
+    exits.reserve(NATIVE_DEPTH_MAX + 1);
+}
+
+JitCompiler::~JitCompiler() {
+#ifdef FRACTUS_JIT_X86_64
+    for (const std::pair<void*, size_t> &mapping : mappings) {
+        munmap(mapping.first, mapping.second);
+    }
+#endif
+}
+
+const RegProcedure &JitCompiler::procedure(size_t index) const {
+    return index == program.procedures.size() ? program.main : program.procedures[index];
+}
+
+NativeStatus JitCompiler::run(const RegProcedure &proc, int32_t *regs, int32_t *globals,
+                              const int32_t *intsEnd, const void *entry) {
+    using NativeFunction = int32_t (*)(int32_t *regs, NativeContext *context, const void *entry);
+    context.globals = globals;
+    context.intsEnd = intsEnd;
+    context.depth = 0;
+    NativeFunction function = reinterpret_cast<NativeFunction>(entries[indexOf(proc)].start);
+    return static_cast<NativeStatus>(function(regs, &context, entry));
+}
+
+bool JitCompiler::nativeCallee(const RegProcedure &callee, bool tail) const {
+    if (!callee.fractions.empty() || !callee.strings.empty() || bankOf(callee.returnType) != Bank::Int) {
+        return false;
+    }
+    // tail calls are not memoized by the VM either
+    return tail || !memo || !callee.pure;
+}
+
+bool JitCompiler::supported(const RegInstr &instr) const {
+    switch (instr.op) {
+        case RegOp::MoveI:
+        case RegOp::GetGlobalI:
+        case RegOp::SetGlobalI:
+        case RegOp::AddI:
+        case RegOp::SubtractI:
+        case RegOp::MultiplyI:
+        case RegOp::DivideI:
+        case RegOp::NegateI:
+        case RegOp::Not:
+        case RegOp::EqualI:
+        case RegOp::NotEqualI:
+        case RegOp::LessI:
+        case RegOp::LessEqualI:
+        case RegOp::GreaterI:
+        case RegOp::GreaterEqualI:
+        case RegOp::Jump:
+        case RegOp::JumpIfFalse:
+        case RegOp::JumpIfTrue:
+        case RegOp::JumpIfEqualI:
+        case RegOp::JumpIfNotEqualI:
+        case RegOp::JumpIfLessI:
+        case RegOp::JumpIfLessEqualI:
+        case RegOp::JumpIfGreaterI:
+        case RegOp::JumpIfGreaterEqualI:
+        case RegOp::ReturnI:
+        case RegOp::ReturnVoid:
+            return true;
+        case RegOp::Call:
+            return nativeCallee(program.procedures[instr.a], false);
+        case RegOp::TailCall:
+            return nativeCallee(program.procedures[instr.a], true);
+        default:
+            return false;
+    }
+}
+
+void JitCompiler::compile(size_t index) {
+    NativeProcedure &native = procedures[index];
+    native.compiled = true;
+#ifdef FRACTUS_JIT_X86_64
+    const RegProcedure &proc = procedure(index);
+    Assembler as;
+    std::vector<size_t> instructions;
+    translate(as, proc, instructions);
+    const char *start = static_cast<const char*>(install(as.finish()));
+    if (!start) {
+        return;
+    }
+    entries[index] = {start, start + as.offsetOf(instructions[0])};
+
+    // loops are entered natively only when their whole body is native
+    native.loopEntries.assign(proc.code.size(), nullptr);
+    for (size_t k = 0; k < proc.code.size(); ++k) {
+        const RegInstr &instr = proc.code[k];
+        if (!isBranch(instr.op) || static_cast<size_t>(instr.c) > k) {
+            continue;
+        }
+        bool whole = true;
+        for (size_t i = static_cast<size_t>(instr.c); i <= k && whole; ++i) {
+            whole = supported(proc.code[i]);
+        }
+        if (whole) {
+            native.loopEntries[instr.c] = start + as.offsetOf(instructions[instr.c]);
+        }
+    }
+
+    // callees of hot code are hot too
+    for (const RegInstr &instr : proc.code) {
+        if ((instr.op == RegOp::Call || instr.op == RegOp::TailCall) && supported(instr)
+            && !procedures[instr.a].compiled) {
+            compile(instr.a);
+        }
+    }
+#endif
+}
+
+void JitCompiler::translate(Assembler &as, const RegProcedure &proc, std::vector<size_t> &instructions) {
+    Assembler::Label leave = as.newLabel();
+    Assembler::Label exit = as.newLabel();
+    Assembler::Label suspended = as.newLabel();
+    instructions.clear();
+    for (size_t k = 0; k < proc.code.size(); ++k) {
+        instructions.push_back(as.newLabel());
+    }
+    // stubs leaving to the VM, placed after the code: label, instruction and result register
+    struct Stub {
+        Assembler::Label label;
+        uint32_t ip;
+        uint32_t result;
+    };
+    std::vector<Stub> stubs;
+    auto stub = [&](uint32_t ip, uint32_t result) {
+        stubs.push_back({as.newLabel(), ip, result});
+        return stubs.back().label;
+    };
+
+    // five pushes keep stack aligned to 16 for calls
+    as.push(Reg::RBX);
+    as.push(Reg::RBP);
+    as.push(Reg::R12);
+    as.push(Reg::R13);
+    as.push(Reg::R14);
+    as.move64(REGS, Reg::RDI);
+    as.move64(CONTEXT, Reg::RSI);
+    as.load64(GLOBALS, CONTEXT, offsetof(NativeContext, globals));
+    as.test64(Reg::RDX, Reg::RDX);
+    as.jumpIf(Cond::Equal, instructions.empty() ? exit : instructions[0]);
+    as.jump(Reg::RDX);
+
+    for (size_t k = 0; k < proc.code.size(); ++k) {
+        const RegInstr &instr = proc.code[k];
+        uint32_t ip = static_cast<uint32_t>(k);
+        as.bind(instructions[k]);
+        switch (instr.op) {
+            case RegOp::MoveI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::GetGlobalI:
+                as.load32(Reg::RAX, GLOBALS, slot(instr.b));
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::SetGlobalI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.store32(GLOBALS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::AddI:
+            case RegOp::SubtractI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.alu32(instr.op == RegOp::AddI ? AluOp::Add : AluOp::Subtract,
+                         Reg::RAX, REGS, slot(instr.c));
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::MultiplyI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.multiply32(Reg::RAX, REGS, slot(instr.c));
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::DivideI: {
+                // division by zero is reported by the VM, which also wraps INT_MIN / -1 around
+                Assembler::Label slow = stub(ip, NO_RESULT);
+                as.load32(Reg::RCX, REGS, slot(instr.c));
+                as.test32(Reg::RCX, Reg::RCX);
+                as.jumpIf(Cond::Equal, slow);
+                as.compare32(Reg::RCX, -1);
+                as.jumpIf(Cond::Equal, slow);
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.divide32(Reg::RCX);
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            }
+            case RegOp::NegateI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.negate32(Reg::RAX);
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::Not:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.test32(Reg::RAX, Reg::RAX);
+                as.setIf(Cond::Equal, Reg::RAX);
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::EqualI:
+            case RegOp::NotEqualI:
+            case RegOp::LessI:
+            case RegOp::LessEqualI:
+            case RegOp::GreaterI:
+            case RegOp::GreaterEqualI:
+                as.load32(Reg::RAX, REGS, slot(instr.b));
+                as.alu32(AluOp::Compare, Reg::RAX, REGS, slot(instr.c));
+                as.setIf(condition(instr.op, RegOp::EqualI), Reg::RAX);
+                as.store32(REGS, slot(instr.a), Reg::RAX);
+                break;
+            case RegOp::Jump:
+                as.jump(instructions[instr.c]);
+                break;
+            case RegOp::JumpIfFalse:
+            case RegOp::JumpIfTrue:
+                as.compare32(REGS, slot(instr.a), 0);
+                as.jumpIf(instr.op == RegOp::JumpIfFalse ? Cond::Equal : Cond::NotEqual,
+                          instructions[instr.c]);
+                break;
+            case RegOp::JumpIfEqualI:
+            case RegOp::JumpIfNotEqualI:
+            case RegOp::JumpIfLessI:
+            case RegOp::JumpIfLessEqualI:
+            case RegOp::JumpIfGreaterI:
+            case RegOp::JumpIfGreaterEqualI:
+                as.load32(Reg::RAX, REGS, slot(instr.a));
+                as.alu32(AluOp::Compare, Reg::RAX, REGS, slot(instr.b));
+                as.jumpIf(condition(instr.op, RegOp::JumpIfEqualI), instructions[instr.c]);
+                break;
+            case RegOp::Call: {
+                const RegProcedure &callee = program.procedures[instr.a];
+                if (!supported(instr)) {
+                    as.jump(stub(ip, NO_RESULT));
+                    break;
+                }
+                // the VM makes the call when callee has no code yet, is too deep or needs more registers
+                Assembler::Label slow = stub(ip, NO_RESULT);
+                as.compare32(CONTEXT, DEPTH, static_cast<int32_t>(NATIVE_DEPTH_MAX));
+                as.jumpIf(Cond::AboveEqual, slow);
+                as.load64(Reg::RAX, CONTEXT, ENTRIES);
+                as.load64(CALLEE, Reg::RAX, entryField(instr.a, offsetof(NativeContext::Entry, start)));
+                as.test64(CALLEE, CALLEE);
+                as.jumpIf(Cond::Equal, slow);
+                as.lea(CALLEE_REGS, REGS, slot(proc.ints.size()));
+                as.lea(Reg::RAX, CALLEE_REGS, slot(callee.ints.size()));
+                as.compare64(Reg::RAX, CONTEXT, INTS_END);
+                as.jumpIf(Cond::Above, slow);
+
+                initialize(as, CALLEE_REGS, callee);
+                for (size_t i = 0; i < callee.params.size(); ++i) {
+                    as.load32(Reg::RAX, REGS, slot(proc.arguments[instr.b + i]));
+                    as.store32(CALLEE_REGS, slot(callee.params[i].reg), Reg::RAX);
+                }
+
+                as.increment32(CONTEXT, DEPTH);
+                as.move64(Reg::RDI, CALLEE_REGS);
+                as.move64(Reg::RSI, CONTEXT);
+                as.xor32(Reg::RDX, Reg::RDX);
+                as.call(CALLEE);
+                as.decrement32(CONTEXT, DEPTH);
+                // callee left to the VM, so does this call
+                Assembler::Label inCall = stub(ip + 1, static_cast<uint32_t>(instr.c));
+                if (callee.returnType == Type::Void) {
+                    as.compare32(Reg::RAX, static_cast<int32_t>(NativeStatus::ReturnedVoid));
+                    as.jumpIf(Cond::NotEqual, inCall);
+                } else {
+                    as.compare32(Reg::RAX, static_cast<int32_t>(NativeStatus::Returned));
+                    as.jumpIf(Cond::NotEqual, inCall);
+                    as.load32(Reg::RAX, CONTEXT, RESULT);
+                    as.store32(REGS, slot(instr.c), Reg::RAX);
+                }
+                break;
+            }
+            case RegOp::TailCall: {
+                const RegProcedure &callee = program.procedures[instr.a];
+                if (!supported(instr)) {
+                    as.jump(stub(ip, NO_RESULT));
+                    break;
+                }
+                Assembler::Label slow = stub(ip, NO_RESULT);
+                as.load64(Reg::RAX, CONTEXT, ENTRIES);
+                as.load64(CALLEE, Reg::RAX, entryField(instr.a, offsetof(NativeContext::Entry, body)));
+                as.test64(CALLEE, CALLEE);
+                as.jumpIf(Cond::Equal, slow);
+                as.lea(Reg::RAX, REGS, slot(callee.ints.size()));
+                as.compare64(Reg::RAX, CONTEXT, INTS_END);
+                as.jumpIf(Cond::Above, slow);
+
+                // arguments wait on native stack while the frame is overwritten
+                for (size_t i = 0; i < callee.params.size(); ++i) {
+                    as.load32(Reg::RAX, REGS, slot(proc.arguments[instr.b + i]));
+                    as.push(Reg::RAX);
+                }
+                initialize(as, REGS, callee);
+                for (size_t i = callee.params.size(); i-- > 0;) {
+                    as.pop(Reg::RAX);
+                    as.store32(REGS, slot(callee.params[i].reg), Reg::RAX);
+                }
+                as.jump(CALLEE);
+                break;
+            }
+            case RegOp::ReturnI:
+                as.load32(Reg::RAX, REGS, slot(instr.a));
+                as.store32(CONTEXT, RESULT, Reg::RAX);
+                as.move32(Reg::RAX, static_cast<int32_t>(NativeStatus::Returned));
+                as.jump(leave);
+                break;
+            case RegOp::ReturnVoid:
+                as.move32(Reg::RAX, static_cast<int32_t>(NativeStatus::ReturnedVoid));
+                as.jump(leave);
+                break;
+            default:
+                as.move32(Reg::RCX, static_cast<int32_t>(ip));
+                as.jump(exit);
+                break;
+        }
+    }
+
+    for (const Stub &s : stubs) {
+        as.bind(s.label);
+        as.move32(Reg::RCX, static_cast<int32_t>(s.ip));
+        if (s.result == NO_RESULT) {
+            as.jump(exit);
+        } else {
+            as.move32(Reg::R8, static_cast<int32_t>(s.result));
+            as.jump(suspended);
+        }
+    }
+
+    // suspend(context, proc, regs, ecx, r8d)
+    as.bind(exit);
+    as.move32(Reg::R8, static_cast<int32_t>(NO_RESULT));
+    as.bind(suspended);
+    as.move64(Reg::RDI, CONTEXT);
+    as.move64(Reg::RSI, reinterpret_cast<uint64_t>(&proc));
+    as.move64(Reg::RDX, REGS);
+    as.move64(Reg::RAX, reinterpret_cast<uint64_t>(&JitCompiler::suspend));
+    as.call(Reg::RAX);
+    as.move32(Reg::RAX, static_cast<int32_t>(NativeStatus::Exited));
+
+    as.bind(leave);
+    as.pop(Reg::R14);
+    as.pop(Reg::R13);
+    as.pop(Reg::R12);
+    as.pop(Reg::RBP);
+    as.pop(Reg::RBX);
+    as.ret();
+}
+
+const void *JitCompiler::install(const std::vector<uint8_t> &code) {
+#ifdef FRACTUS_JIT_X86_64
+    // written while writable, run only after it is made executable
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (code.size() + page - 1) / page * page;
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    mappings.emplace_back(memory, size);
+    return memory;
+#else
+    return nullptr;
+#endif
+}
+
+void JitCompiler::suspend(NativeContext *context, const RegProcedure *proc, int32_t *regs,
+                          uint32_t ip, uint32_t result) {
+    context->exits->push_back({proc, regs, ip, result});
+}
@@ -0,0 +1,140 @@
+//
+// Baseline compiler of hot register code to x86-64 machine code
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_JITCOMPILER_H
+#define FRACTUS_JITCOMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "RegisterCode.h"
+
+// machine code is generated only where it can be run
+#if defined(__x86_64__) && defined(__linux__)
+#define FRACTUS_JIT_X86_64
+#endif
+
+class Assembler;
+
+enum class NativeStatus : int32_t {
+    Returned,       // procedure returned value in NativeContext::result
+    ReturnedVoid,
+    Exited          // execution left to the VM, frames in NativeContext::exits
+};
+
+/**
+ * Point where native code stopped: an instruction it does not handle,
+ * or a call in progress when that happened deeper.
+ */
+struct DeoptFrame {
+    const RegProcedure *proc;
+    int32_t *regs;
+    uint32_t ip;      // instruction to continue with
+    uint32_t result;  // register receiving result of the call in progress
+};
+
+// shared by all native code, its fields are addressed by generated instructions
+struct NativeContext {
+    struct Entry {
+        const void *start; // function taking (regs, context, entry address or null)
+        const void *body;  // first instruction, for tail calls
+    };
+
+    int32_t *globals;
+    const int32_t *intsEnd;      // native calls must fit their registers below it
+    const Entry *entries;        // by index of procedure, null where there is no code
+    uint32_t depth;              // native calls nested now
+    int32_t result;
+    std::vector<DeoptFrame> *exits; // innermost first
+};
+
+/**
+ * Translates procedures of register code which run often into machine code.
+ * Only integer and boolean registers are handled natively: instructions
+ * on fractions and strings, I/O and errors leave to the VM, which continues
+ * from the same registers. Procedures are compiled after HOT_CALLS calls
+ * or HOT_LOOPS jumps back; native code calls other compiled procedures
+ * directly when their registers are all integers.
+ */
+class JitCompiler {
+public:
+    static const uint32_t HOT_CALLS = 100;
+    static const uint32_t HOT_LOOPS = 1000;
+    // native calls use native stack, deeper ones are left to the VM
+    static const uint32_t NATIVE_DEPTH_MAX = 1 << 14;
+
+    JitCompiler(const RegProgram &program, bool memo);
+    JitCompiler(const JitCompiler &) = delete;
+    JitCompiler &operator=(const JitCompiler &) = delete;
+    ~JitCompiler();
+
+    // counts call of proc, true when it has native code
+    bool hotCall(const RegProcedure &proc) {
+        size_t index = indexOf(proc);
+        NativeProcedure &native = procedures[index];
+        if (!native.compiled && ++native.calls >= HOT_CALLS) {
+            compile(index);
+        }
+        return entries[index].start != nullptr;
+    }
+    // counts jump back to instruction target, address to enter native code there or null
+    const void *hotLoop(const RegProcedure &proc, size_t target) {
+        size_t index = indexOf(proc);
+        NativeProcedure &native = procedures[index];
+        if (!native.compiled && ++native.loops >= HOT_LOOPS) {
+            compile(index);
+        }
+        return native.loopEntries.empty() ? nullptr : native.loopEntries[target];
+    }
+
+    // runs native code of proc at entry (null for the first instruction) on registers regs
+    NativeStatus run(const RegProcedure &proc, int32_t *regs, int32_t *globals,
+                     const int32_t *intsEnd, const void *entry);
+    int32_t getResult() const {
+        return context.result;
+    }
+    std::vector<DeoptFrame> &getExits() {
+        return exits;
+    }
+
+private:
+    struct NativeProcedure {
+        uint32_t calls = 0;
+        uint32_t loops = 0;
+        bool compiled = false;          // attempted, code may still be missing
+        std::vector<const void*> loopEntries; // at targets of jumps back, null elsewhere
+    };
+
+    size_t indexOf(const RegProcedure &proc) const {
+        if (&proc == &program.main) {
+            return program.procedures.size();
+        }
+        return static_cast<size_t>(&proc - program.procedures.data());
+    }
+    const RegProcedure &procedure(size_t index) const;
+    // callee can be called natively: no fraction and string registers, memoized calls go through VM
+    bool nativeCallee(const RegProcedure &callee, bool tail) const;
+    bool supported(const RegInstr &instr) const;
+
+    void compile(size_t index);
+    // instructions[k] is bound to native code of k-th instruction
+    void translate(Assembler &as, const RegProcedure &proc, std::vector<size_t> &instructions);
+    const void *install(const std::vector<uint8_t> &code);
+
+    static void suspend(NativeContext *context, const RegProcedure *proc, int32_t *regs,
+                        uint32_t ip, uint32_t result);
+
+    const RegProgram &program;
+    bool memo;
+    std::vector<NativeProcedure> procedures; // main is the last one
+    std::vector<NativeContext::Entry> entries;
+    std::vector<DeoptFrame> exits;
+    NativeContext context;
+    std::vector<std::pair<void*, size_t>> mappings;
+};
+
+#endif //FRACTUS_JITCOMPILER_H
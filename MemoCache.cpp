@@ -0,0 +1,55 @@
+//
+// MemoCache source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <functional>
+
+#include "MemoCache.h"
+
+MemoCache::MemoCache(size_t capacity)
+: capacity(capacity)
+, lookupKey{nullptr, {}}
+, hits(0)
+, misses(0)
+{}
+
+const ValType *MemoCache::find(const void *proc, const ValType *args, size_t count) {
+    lookupKey.proc = proc;
+    lookupKey.args.assign(args, args + count);
+    auto it = entries.find(lookupKey);
+    if (it == entries.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    return &it->second;
+}
+
+void MemoCache::insert(const void *proc, const ValType *args, size_t count, const ValType &result) {
+    if (entries.size() >= capacity) {
+        entries.clear();
+    }
+    entries.emplace(Key{proc, std::vector<ValType>(args, args + count)}, result);
+}
+
+size_t MemoCache::KeyHash::operator()(const Key &key) const {
+    size_t hash = std::hash<const void*>()(key.proc);
+    for (const ValType &arg : key.args) {
+        hash = hash * 31 + hashValue(arg);
+    }
+    return hash;
+}
+
+bool MemoCache::KeyEqual::operator()(const Key &left, const Key &right) const {
+    if (left.proc != right.proc || left.args.size() != right.args.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < left.args.size(); ++i) {
+        // arguments of one parameter have the same type
+        if (!(left.args[i] == right.args[i])) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+//
+// Cache of results of pure procedure calls
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_MEMOCACHE_H
+#define FRACTUS_MEMOCACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "Scope.h"
+
+/**
+ * Results of calls keyed by procedure and values of arguments.
+ * Only procedures classified as pure by SemanticAnalyzer may be cached,
+ * their result depends on arguments alone. The cache holds at most
+ * capacity entries, it is emptied when it gets full.
+ */
+class MemoCache {
+public:
+    MemoCache(size_t capacity);
+
+    // result of earlier call with equal arguments, null if there was none
+    const ValType *find(const void *proc, const ValType *args, size_t count);
+    void insert(const void *proc, const ValType *args, size_t count, const ValType &result);
+
+    size_t getHits() const {
+        return hits;
+    }
+    size_t getMisses() const {
+        return misses;
+    }
+
+private:
+    struct Key {
+        const void *proc;
+        std::vector<ValType> args;
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+    struct KeyEqual {
+        bool operator()(const Key &left, const Key &right) const;
+    };
+
+    size_t capacity;
+    std::unordered_map<Key, ValType, KeyHash, KeyEqual> entries;
+    Key lookupKey; // reused by find, so lookups do not allocate
+    size_t hits;
+    size_t misses;
+};
+
+#endif //FRACTUS_MEMOCACHE_H
@@ -0,0 +1,98 @@
+//
+// Integer kernels shared by numeric types
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_NUMERIC_H
+#define FRACTUS_NUMERIC_H
+
+#include <cstdint>
+
+/**
+ * Binary (Stein) greatest common divisor.
+ * Common powers of two are stripped with a single count of trailing
+ * zeros, the loop then only subtracts and shifts odd numbers,
+ * which is cheaper than repeated division of Euclid's algorithm.
+ */
+inline uint64_t greatestCommonDivisor(uint64_t a, uint64_t b) {
+    if (a < b) {
+        uint64_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b == 0) {
+        return a;
+    }
+    // single division balances operands of different magnitude
+    a %= b;
+    if (a == 0) {
+        return b;
+    }
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    b >>= __builtin_ctzll(b);
+    while (a != b) {
+        // branch free step, difference of odd numbers is even
+        uint64_t min = a < b ? a : b;
+        uint64_t diff = a < b ? b - a : a - b;
+        a = min;
+        b = diff >> __builtin_ctzll(diff);
+    }
+    return a << shift;
+}
+
+// count of trailing zeros of nonzero 128-bit value
+inline int countTrailingZeros(unsigned __int128 v) {
+    uint64_t low = static_cast<uint64_t>(v);
+    return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(static_cast<uint64_t>(v >> 64));
+}
+
+inline unsigned __int128 greatestCommonDivisor(unsigned __int128 a, unsigned __int128 b) {
+    if (a == 0) {
+        return b;
+    }
+    if (b == 0) {
+        return a;
+    }
+    int shift = countTrailingZeros(a | b);
+    a >>= countTrailingZeros(a);
+    do {
+        b >>= countTrailingZeros(b);
+        if (a > b) {
+            unsigned __int128 t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+        // back on machine words as soon as both fit
+        if ((a >> 64) == 0 && (b >> 64) == 0) {
+            return static_cast<unsigned __int128>(
+                    greatestCommonDivisor(static_cast<uint64_t>(a), static_cast<uint64_t>(b))) << shift;
+        }
+    } while (b != 0);
+    return a << shift;
+}
+
+inline uint64_t absoluteValue(int64_t v) {
+    return v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+}
+
+// integer quotient, INT32_MIN / -1 wraps around to INT32_MIN instead of trapping
+inline int32_t wrappingDivide(int32_t left, int32_t right) {
+    if (right == -1) {
+        return static_cast<int32_t>(0 - static_cast<uint32_t>(left));
+    }
+    return left / right;
+}
+
+/**
+ * Least common multiple of positive numbers.
+ * Divides before multiplying; caller has to make sure the result fits
+ * (two int denominators always do).
+ */
+inline int64_t leastCommonMultiple(int64_t a, int64_t b) {
+    uint64_t g = greatestCommonDivisor(static_cast<uint64_t>(a), static_cast<uint64_t>(b));
+    return a / static_cast<int64_t>(g) * b;
+}
+
+#endif //FRACTUS_NUMERIC_H
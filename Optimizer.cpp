@@ -0,0 +1,337 @@
+//
+// Optimizer source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <climits>
+#include <stdexcept>
+
+#include "Optimizer.h"
+#include "Interpreter.h"
+
+namespace {
+
+/**
+ * Counts writes of every variable and finds global variables
+ * used by procedures, before anything is rewritten
+ */
+class WriteCounter : public Visitor {
+public:
+    WriteCounter(std::map<Optimizer::Variable, int> &writes, std::set<Optimizer::Variable> &usedInProcedures)
+    : writes(writes)
+    , usedInProcedures(usedInProcedures)
+    , currentProc(nullptr)
+    {}
+
+    void visit(const BinOpNode *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const LogicalOp *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const NumNode *n) {}
+    void visit(const UnaryOpNode *n) {
+        n->expression->accept(*this);
+    }
+    void visit(const CompoundNode *n) {
+        for (Node *child : n->children) {
+            child->accept(*this);
+        }
+    }
+    void visit(const AssignNode *n) {
+        n->left->accept(*this);
+        ++writes[variable(n->left)];
+        n->right->accept(*this);
+    }
+    void visit(const IfNode *n) {
+        n->condition->accept(*this);
+        n->thenNode->accept(*this);
+        if (n->elseNode) {
+            n->elseNode->accept(*this);
+        }
+    }
+    void visit(const WhileNode *n) {
+        n->condition->accept(*this);
+        n->statement->accept(*this);
+    }
+    void visit(const ReturnNode *n) {
+        n->expr->accept(*this);
+    }
+    void visit(const VarNode *n) {
+        if (currentProc && n->depth > 0) {
+            usedInProcedures.insert(variable(n));
+        }
+    }
+    void visit(const ProgramNode *n) {
+        n->block->accept(*this);
+    }
+    void visit(const BlockNode *n) {
+        for (ProcDeclNode *proc : n->procDeclarations) {
+            proc->accept(*this);
+        }
+        n->compundStatement->accept(*this);
+    }
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n) {
+        const ProcDeclNode *enclosingProc = currentProc;
+        currentProc = n;
+        // parameters are set by every call
+        for (unsigned int slot = 0; slot < n->params.size(); ++slot) {
+            ++writes[{n, slot}];
+        }
+        n->blockNode->accept(*this);
+        currentProc = enclosingProc;
+    }
+    void visit(const ProcCallNode *n) {
+        for (Node *arg : n->arguments) {
+            arg->accept(*this);
+        }
+        if (n->builtin == builtinRead) {
+            ++writes[variable(static_cast<const VarNode*>(n->arguments[0]))];
+        }
+    }
+
+private:
+    Optimizer::Variable variable(const VarNode *n) const {
+        // variables of enclosing scope can only be the global ones
+        return {n->depth > 0 ? nullptr : currentProc, n->slot};
+    }
+
+    std::map<Optimizer::Variable, int> &writes;
+    std::set<Optimizer::Variable> &usedInProcedures;
+    const ProcDeclNode *currentProc;
+};
+
+const NumNode *constant(const Node *n) {
+    return dynamic_cast<const NumNode*>(n);
+}
+
+Token constantToken(Type type) {
+    switch (type) {
+        case Type::Int:
+            return INTCONST;
+        case Type::Fraction:
+            return FRACTCONST;
+        case Type::String:
+            return CHARCONST;
+        default:
+            return IDENTIFIER; // true and false
+    }
+}
+
+// integer operations whose result does not fit in int, left to be run
+bool overflows(Token op, const ValType &left, const ValType &right) {
+    if (left.type() != Type::Int) {
+        return false;
+    }
+    int l = left.intVal(), r = right.intVal(), result;
+    switch (op) {
+        case PLUS:
+            return __builtin_add_overflow(l, r, &result);
+        case MINUS:
+            return __builtin_sub_overflow(l, r, &result);
+        case MULTSIGN:
+            return __builtin_mul_overflow(l, r, &result);
+        case DIVSIGN:
+            return l == INT_MIN && r == -1;
+        default:
+            return false;
+    }
+}
+
+}
+
+Optimizer::Optimizer(Arena &arena, int level)
+: Rewriter(arena)
+, level(level)
+, currentProc(nullptr)
+, currentBody(nullptr)
+{}
+
+void Optimizer::optimize(ProgramNode *program) {
+    // -O0 runs the tree as it was checked
+    if (level < 1) {
+        return;
+    }
+    if (level >= 2) {
+        WriteCounter counter(writes, usedInProcedures);
+        program->accept(counter);
+    }
+    program->accept(*this);
+}
+
+Optimizer::Variable Optimizer::variable(const VarNode *n) const {
+    return {n->depth > 0 ? nullptr : currentProc, n->slot};
+}
+
+void Optimizer::replaceWithConstant(const ValType &value) {
+    replacement = arena.make<NumNode>(constantToken(value.type()), value);
+}
+
+/**
+ * Folding of expressions
+ */
+
+void Optimizer::visit(const BinOpNode *n) {
+    rewrite(n->left);
+    rewrite(n->right);
+    const NumNode *left = constant(n->left), *right = constant(n->right);
+    if (left && right && !overflows(n->op, left->constant, right->constant)) {
+        try {
+            replaceWithConstant(Interpreter::binaryOperation(n->op, left->constant, right->constant));
+        } catch (const std::runtime_error &e) {
+            // reported when the operation is run
+        }
+    }
+}
+
+void Optimizer::visit(const LogicalOp *n) {
+    rewrite(n->left);
+    rewrite(n->right);
+    const NumNode *left = constant(n->left);
+    if (left) {
+        // result is the left operand if it decides, the right one otherwise
+        bool decides = left->constant.boolVal() == (n->op == OROP);
+        replacement = decides ? n->left : n->right;
+    }
+}
+
+void Optimizer::visit(const UnaryOpNode *n) {
+    rewrite(n->expression);
+    const NumNode *operand = constant(n->expression);
+    if (operand && !(operand->constant.type() == Type::Int && operand->constant.intVal() == INT_MIN)) {
+        replaceWithConstant(Interpreter::unaryOperation(n->op, operand->constant));
+    }
+}
+
+void Optimizer::visit(const VarNode *n) {
+    if (level < 2) {
+        return;
+    }
+    Variable var = variable(n);
+    auto known = constants.find(var);
+    if (known != constants.end()) {
+        replaceWithConstant(known->second);
+    } else if (writes.find(var) == writes.end()) {
+        // never written, keeps initial value (see initialValue)
+        switch (n->type) {
+            case Type::Bool:
+                replaceWithConstant(ValType::fromBool(n->name == SYM_TRUE));
+                break;
+            case Type::Int:
+                replaceWithConstant(ValType::fromInt(0));
+                break;
+            case Type::String:
+                replaceWithConstant(ValType::fromString(std::string()));
+                break;
+            case Type::Fraction:
+                replaceWithConstant(ValType::fromFraction(Fraction()));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Statements
+ */
+
+void Optimizer::visit(const CompoundNode *n) {
+    bool topLevel = n == currentBody;
+    for (Node *const &child : n->children) {
+        rewrite(child);
+
+        // single assignment of constant at top level of a body is done
+        // before any later statement of the body runs
+        const AssignNode *assign = dynamic_cast<const AssignNode*>(child);
+        if (level >= 2 && topLevel && assign && constant(assign->right)) {
+            Variable var = variable(assign->left);
+            if (writes[var] == 1 && (var.first || !usedInProcedures.count(var))) {
+                constants[var] = constant(assign->right)->constant;
+            }
+        }
+    }
+}
+
+void Optimizer::visit(const AssignNode *n) {
+    rewrite(n->right);
+}
+
+void Optimizer::visit(const IfNode *n) {
+    rewrite(n->condition);
+    rewrite(n->thenNode);
+    if (n->elseNode) {
+        rewrite(n->elseNode);
+    }
+    const NumNode *condition = constant(n->condition);
+    if (condition) {
+        if (condition->constant.boolVal()) {
+            replacement = n->thenNode;
+        } else {
+            replacement = n->elseNode ? n->elseNode : arena.make<CompoundNode>();
+        }
+    }
+}
+
+void Optimizer::visit(const WhileNode *n) {
+    rewrite(n->condition);
+    rewrite(n->statement);
+    const NumNode *condition = constant(n->condition);
+    if (condition && !condition->constant.boolVal()) {
+        replacement = arena.make<CompoundNode>();
+    }
+}
+
+void Optimizer::visit(const ReturnNode *n) {
+    rewrite(n->expr);
+}
+
+void Optimizer::visit(const ProcCallNode *n) {
+    // argument of read stays a variable
+    if (n->builtin == builtinRead) {
+        return;
+    }
+    for (Node *const &arg : n->arguments) {
+        rewrite(arg);
+    }
+}
+
+/**
+ * Program structure
+ */
+
+void Optimizer::visit(const ProgramNode *n) {
+    n->block->accept(*this);
+}
+
+void Optimizer::visit(const BlockNode *n) {
+    for (ProcDeclNode *proc : n->procDeclarations) {
+        proc->accept(*this);
+    }
+    body(currentProc, n);
+}
+
+void Optimizer::visit(const ProcDeclNode *n) {
+    const ProcDeclNode *enclosingProc = currentProc;
+    currentProc = n;
+    n->blockNode->accept(*this);
+    currentProc = enclosingProc;
+}
+
+void Optimizer::body(const ProcDeclNode *proc, const BlockNode *block) {
+    // values known in one body are not known in other ones
+    std::map<Variable, ValType> enclosingConstants;
+    enclosingConstants.swap(constants);
+    const CompoundNode *enclosingBody = currentBody;
+    currentBody = block->compundStatement;
+
+    block->compundStatement->accept(*this);
+
+    currentBody = enclosingBody;
+    constants.swap(enclosingConstants);
+}
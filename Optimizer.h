@@ -0,0 +1,63 @@
+//
+// Constant folding and propagation over checked AST
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_OPTIMIZER_H
+#define FRACTUS_OPTIMIZER_H
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include "Rewriter.h"
+
+/**
+ * Tree visitor simplifying program before it is run. Levels:
+ *  0 - leaves the tree unchanged,
+ *  1 - folds operators with constant operands and statements
+ *      with constant conditions,
+ *  2 - also replaces variables of known constant value by the value.
+ * Operations which would fail (division by zero) are left for runtime.
+ */
+class Optimizer : public Rewriter {
+public:
+    // variable: procedure declaring it (null for global ones) and its slot
+    using Variable = std::pair<const ProcDeclNode*, unsigned int>;
+
+    Optimizer(Arena &arena, int level);
+
+    void optimize(ProgramNode *program);
+
+    void visit(const BinOpNode *n);
+    void visit(const LogicalOp *n);
+    void visit(const NumNode *n) {}
+    void visit(const UnaryOpNode *n);
+    void visit(const CompoundNode *n);
+    void visit(const AssignNode *n);
+    void visit(const IfNode *n);
+    void visit(const WhileNode *n);
+    void visit(const ReturnNode *n);
+    void visit(const VarNode *n);
+    void visit(const ProgramNode *n);
+    void visit(const BlockNode *n);
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n);
+    void visit(const ProcCallNode *n);
+
+private:
+    Variable variable(const VarNode *n) const;
+    void body(const ProcDeclNode *proc, const BlockNode *block);
+    void replaceWithConstant(const ValType &value);
+
+    int level;
+    const ProcDeclNode *currentProc;       // null in main program
+    const CompoundNode *currentBody;       // top level statements of procedure or main program
+    std::map<Variable, int> writes;        // assignments, reads from input and parameters
+    std::set<Variable> usedInProcedures;   // global variables
+    std::map<Variable, ValType> constants; // values known in current statement
+};
+
+#endif //FRACTUS_OPTIMIZER_H
@@ -9,52 +9,23 @@
 
 Parser::Parser(Scanner &scanner)
     : scanner(scanner) {
-    relOp = { EQOP, LTOP, GTOP, LEOP, GEOP, NEQOP, OROP, ANDOP };
-    addOp = { PLUS, MINUS };
-    multOp = { MULTSIGN, DIVSIGN };
-    sign = { PLUS, MINUS };
-    varTypes = { STRINGTYPE, BOOLEANTYPE, INTEGERTYPE, FRACTIONTYPE };
-    retTypes = { VOIDTYPE, STRINGTYPE, BOOLEANTYPE, INTEGERTYPE, FRACTIONTYPE };
-    procParams = { IDENTIFIER, INTCONST, FRACTCONST, CHARCONST };
-
     nextSymbol();
 }
 
-void Parser::accept(const Token &tkn) {
-    if (symbol == tkn) {
-            nextSymbol();
-    } else {
-        throw ParseException("Syntax error: unexpected atom");
-    }
-}
-
-void Parser::accept(const SymSet& sset) {
-    if (sset.find(symbol) != sset.end()) {
-            nextSymbol();
-    } else {
-        throw ParseException("Syntax error: unexpected atom");
-    }
-}
-
-bool Parser::has(const SymSet &sset, const Token &tkn) {
-    return sset.find(tkn) != sset.end();
-}
-
-void Parser::nextSymbol() {
-    try {
-        symbol = scanner.nextSymbol();
-    } catch (const ScannerException &e) {
-        throw e;
-    }
+void Parser::unexpectedSymbol() {
+    throw ParseException("Syntax error: unexpected atom");
 }
 
-ProgramNode* Parser::parse() {
-    ProgramNode *node = program();
+SyntaxTree Parser::parse() {
+    SyntaxTree tree;
+    tree.program = program();
     if (symbol != END_OF_FILE) {
         std::cout << "Parse error: current token '"<< symbol
                   << "' is different than EOF!" << std::endl;
     }
-    return node;
+    // nodes are released together with the tree
+    tree.arena = std::move(arena);
+    return tree;
 }
 
 ProgramNode* Parser::program() {
@@ -63,11 +34,11 @@ ProgramNode* Parser::program() {
      */
     accept(PROGRAM);
     VarNode *varNode = var();
-    std::cout << "Program name: " << varNode->name << std::endl;
+    const std::string &programName = SymbolTable::name(varNode->name);
+    std::cout << "Program name: " << programName << std::endl;
     accept(SEMICOLON);
     BlockNode *blockNode = block();
-    ProgramNode *programNode = new ProgramNode(varNode->name, blockNode);
-    delete varNode;
+    ProgramNode *programNode = arena.make<ProgramNode>(programName, blockNode);
     accept(PERIOD);
     return programNode;
 }
@@ -81,7 +52,7 @@ BlockNode* Parser::block() {
     varDecls = variablePart();
     procDecls = functionPart();
     CompoundNode *compoundNode = compoundStatement();
-    BlockNode *blockNode = new BlockNode(varDecls, procDecls, compoundNode);
+    BlockNode *blockNode = arena.make<BlockNode>(varDecls, procDecls, compoundNode);
     return blockNode;
 }
 
@@ -113,23 +84,37 @@ std::vector<VarDeclNode*> Parser::variableDeclaration() {
 
     while (symbol == COMMA) {
         accept(COMMA);
-        varNodes.push_back(new VarNode(scanner.getLastString()));
+        varNodes.push_back(arena.make<VarNode>(scanner.getLastSymbol()));
         accept(IDENTIFIER);
     }
     accept(COLON);
 
-    std::shared_ptr<TypeNode> typeNode(varType());
-    //TypeNode *typeNode = varType();
+    TypeNode *typeNode = varType();
     for (VarNode* varNode : varNodes) {
-        varDecls.push_back(new VarDeclNode(varNode, typeNode));
+        varDecls.push_back(arena.make<VarDeclNode>(varNode, typeNode));
     }
     return varDecls;
 }
 
-TypeNode* Parser::type(const SymSet &prefTypes) {
-    std::string typeName = scanner.getLastString();
+Symbol Parser::typeSymbol(Token typeToken) {
+    switch (typeToken) {
+        case INTEGERTYPE:
+            return SYM_INTEGER;
+        case BOOLEANTYPE:
+            return SYM_BOOLEAN;
+        case STRINGTYPE:
+            return SYM_STRING;
+        case FRACTIONTYPE:
+            return SYM_FRACTION;
+        default:
+            return SYM_VOID;
+    }
+}
+
+TypeNode* Parser::type(SymSet prefTypes) {
+    Symbol typeName = typeSymbol(symbol);
     accept(prefTypes);
-    TypeNode *typeNode = new TypeNode(typeName);
+    TypeNode *typeNode = arena.make<TypeNode>(typeName);
     return typeNode;
 }
 
@@ -166,15 +151,15 @@ ProcDeclNode* Parser::functionDeclaration() {
      *         Type, Identifier } ] , ')' , ';' , Block
      */
     TypeNode *rType = retType();
-    std::string procName = scanner.getLastString();
+    Symbol procName = scanner.getLastSymbol();
     accept(IDENTIFIER);
 
     std::vector<ParamNode*> params;
     accept(PARENOPEN);
     while (has(varTypes, symbol)) {
-        std::shared_ptr<TypeNode> paramType(varType());
+        TypeNode *paramType = varType();
         VarNode *varNode = var();
-        params.push_back(new ParamNode(varNode, paramType));
+        params.push_back(arena.make<ParamNode>(varNode, paramType));
         if (symbol == COMMA) {
             accept(COMMA);
         }
@@ -182,7 +167,7 @@ ProcDeclNode* Parser::functionDeclaration() {
     accept(PARENCLOSE);
     accept(SEMICOLON);
     BlockNode *blockNode = block();
-    ProcDeclNode *procDeclNode = new ProcDeclNode(procName, rType, params, blockNode);
+    ProcDeclNode *procDeclNode = arena.make<ProcDeclNode>(procName, rType, params, blockNode);
     return procDeclNode;
 }
 
@@ -204,7 +189,7 @@ CompoundNode* Parser::compoundStatement() {
 //    }
 //    while (has({RETURN,IF,WHILE,BEGIN,IDENTIFIER},symbol));
     accept(END);
-    CompoundNode *compoundNode = new CompoundNode();
+    CompoundNode *compoundNode = arena.make<CompoundNode>();
     compoundNode->children = std::move(statements);
     return compoundNode;
 }
@@ -254,7 +239,7 @@ AssignNode* Parser::assignment(VarNode *preloadedLeft) {
     VarNode *left = preloadedLeft ? preloadedLeft : var();
     accept(EQALSIGN);
     Node *right = expression();
-    AssignNode *assignNode = new AssignNode(left, right);
+    AssignNode *assignNode = arena.make<AssignNode>(left, right);
     return assignNode;
 }
 
@@ -265,7 +250,7 @@ ProcCallNode* Parser::functionCall(VarNode *preloadedProcId) {
     ProcCallNode *node;
     std::vector<Node*> args;
     VarNode *procId = preloadedProcId ? preloadedProcId : var();
-    node = new ProcCallNode(procId, args);
+    node = arena.make<ProcCallNode>(procId, args);
 
     accept(PARENOPEN);
     if (symbol == PARENCLOSE) { // 0 arguments
@@ -287,7 +272,7 @@ Node* Parser::functionReturn() {
      * "return" , Expr
      */
     accept(RETURN);
-    return new ReturnNode(expression());
+    return arena.make<ReturnNode>(expression());
 }
 
 IfNode* Parser::ifStatement() {
@@ -313,7 +298,7 @@ IfNode* Parser::simpleIfStatement() {
     accept(PARENCLOSE);
     accept(THEN);
     thenNode = statement();
-    return new IfNode(expr, thenNode, nullptr);
+    return arena.make<IfNode>(expr, thenNode, nullptr);
 }
 
 WhileNode* Parser::whileStatement() {
@@ -325,64 +310,80 @@ WhileNode* Parser::whileStatement() {
     expr = expression();
     accept(DO);
     stmt = statement();
-    return new WhileNode(expr, stmt);
+    return arena.make<WhileNode>(expr, stmt);
 }
 
+/**
+ * Binding powers of binary operators, 0 for tokens which end an expression.
+ * Relational and logical operators share the lowest level and do not chain,
+ * sign binds a whole term and '!' a single factor.
+ */
+
+static const int REL_BP = 1;
+static const int ADD_BP = 2;
+static const int MULT_BP = 3;
+static const int FACTOR_BP = 4;
+
+struct BindingPowers {
+    constexpr BindingPowers() : power() {
+        for (Token t : { EQOP, NEQOP, LTOP, GTOP, LEOP, GEOP, OROP, ANDOP }) {
+            power[t] = REL_BP;
+        }
+        power[PLUS] = power[MINUS] = ADD_BP;
+        power[MULTSIGN] = power[DIVSIGN] = MULT_BP;
+    }
+
+    int power[OTHERS + 1];
+};
+
+static constexpr BindingPowers bindingPowers;
+
 Node* Parser::expression() {
     /**
      * SimpExpr [, RelOp , SimpExpr ] ;
+     * SimpExpr = [Sign ,] Term , { AddOp , Term } | Bool ;
+     * Term = Factor , { MultOp , Factor } ;
      */
-    Node *node = simpleExpression();
-    if (has(relOp, symbol)) {
-        Token op = symbol;
-        accept(relOp);
-        if (op == ANDOP || op == OROP) {
-            node = new LogicalOp(node, op, simpleExpression());
-        } else {
-            node = new BinOpNode(node, op, simpleExpression());
-        }
-    }
-    return node;
+    return expression(REL_BP);
 }
 
-Node* Parser::simpleExpression() {
-    /**
-     * [Sign ,] Term , { AddOp , Term } | Bool
-     */
+Node* Parser::expression(int minPower) {
     Node *node;
-    std::string id = scanner.getLastString();
-    if (symbol == IDENTIFIER && (id == "true" || id == "false")) {
-        node = new VarNode(id);
+    int maxPower = REL_BP; // operators allowed after left operand
+    Symbol id = scanner.getLastSymbol();
+    if (minPower <= ADD_BP && symbol == IDENTIFIER && (id == SYM_TRUE || id == SYM_FALSE)) {
+        // Bool is a whole SimpExpr, only relational operator may follow
+        node = arena.make<VarNode>(id);
         accept(IDENTIFIER);
-        return node;
-    }
-
-    if (has(sign, symbol)) {
+    } else if (minPower <= ADD_BP && has(sign, symbol)) {
         Token sign_ = symbol;
         accept(sign);
-        node = new UnaryOpNode(sign_, term());
+        node = arena.make<UnaryOpNode>(sign_, expression(MULT_BP));
+        maxPower = MULT_BP;
     } else {
-        node = term();
-    }
-    while (has(addOp, symbol)) {
-        Token op = symbol;
-        accept(addOp);
-        node = new BinOpNode(node, op, term());
+        node = factor();
+        maxPower = MULT_BP;
     }
-    return node;
-}
 
-Node* Parser::term() {
-    /**
-     * Factor , { MultOp , Factor }
-     */
-    Node *node = factor();
-    while (has(multOp, symbol)) {
+    for (;;) {
         Token op = symbol;
-        accept(multOp);
-        node = new BinOpNode(node, op, factor());
+        int power = bindingPowers.power[op];
+        if (power < minPower || power > maxPower) {
+            return node;
+        }
+        accept(op);
+        if (power == REL_BP) {
+            Node *right = expression(ADD_BP);
+            if (op == ANDOP || op == OROP) {
+                node = arena.make<LogicalOp>(node, op, right);
+            } else {
+                node = arena.make<BinOpNode>(node, op, right);
+            }
+            maxPower = 0; // relational operators do not chain
+        } else {
+            node = arena.make<BinOpNode>(node, op, expression(power + 1));
+        }
     }
-    return node;
 }
 
 Node* Parser::factor() {
@@ -403,15 +404,15 @@ Node* Parser::factor() {
             }
         }
         case FRACTCONST:
-            node = new FractNode(symbol, scanner.getLastFraction());
+            node = arena.make<FractNode>(symbol, scanner.getLastFraction());
             accept(FRACTCONST);
             break;
         case INTCONST:
-            node = new IntNode(symbol, scanner.getLastNumber());
+            node = arena.make<IntNode>(symbol, scanner.getLastNumber());
             accept(INTCONST);
             break;
         case CHARCONST:
-            node = new StringNode(symbol, scanner.getLastString());
+            node = arena.make<StringNode>(symbol, scanner.getLastString());
             accept(CHARCONST);
             break;
         case PARENOPEN:
@@ -421,11 +422,11 @@ Node* Parser::factor() {
             break;
         case NOTSIGN: {
             accept(NOTSIGN);
-            node = new UnaryOpNode(NOTSIGN, factor());
+            node = arena.make<UnaryOpNode>(NOTSIGN, factor());
             break;
         }
         default:
-            break;
+            unexpectedSymbol();
     }
     return node;
 }
@@ -434,7 +435,7 @@ VarNode* Parser::var() {
     /**
      * Identifier
      */
-    VarNode* varNode = new VarNode(scanner.getLastString());
+    VarNode* varNode = arena.make<VarNode>(scanner.getLastSymbol());
     accept(IDENTIFIER);
     return varNode;
 }
\ No newline at end of file
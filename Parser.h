@@ -6,7 +6,8 @@
 #ifndef FRACTUS_PARSER_H
 #define FRACTUS_PARSER_H
 
-#include <set>
+#include <cstdint>
+#include <initializer_list>
 
 #include "Ast.h"
 
@@ -16,26 +17,60 @@ public:
 };
 
 
+/**
+ * Set of tokens stored as bitmask over Token enum
+ */
+class SymSet {
+public:
+    constexpr SymSet(std::initializer_list<Token> tokens) : bits(0) {
+        for (Token t : tokens) {
+            bits |= uint64_t(1) << t;
+        }
+    }
+
+    constexpr bool has(Token t) const {
+        return (bits >> t) & 1;
+    }
+
+private:
+    uint64_t bits;
+};
+
+static_assert(OTHERS < 64, "every token needs a bit in SymSet");
+
 /**
  * Parser of FraCtuS language
  */
 class Parser {
-    using SymSet = std::set<Token>;
-
 public:
     Parser(Scanner &scanner);
     ~Parser() {}
 
-    ProgramNode* parse();
+    SyntaxTree parse();
     Token getCurrSymbol() const {
         return symbol;
     }
 
 private:
-    void accept(const Token& tkn);
-    void accept(const SymSet& sset);
-    bool has(const SymSet &sset, const Token &tkn);
-    void nextSymbol();
+    void accept(Token tkn) {
+        if (symbol != tkn) {
+            unexpectedSymbol();
+        }
+        nextSymbol();
+    }
+    void accept(SymSet sset) {
+        if (!sset.has(symbol)) {
+            unexpectedSymbol();
+        }
+        nextSymbol();
+    }
+    static bool has(SymSet sset, Token tkn) {
+        return sset.has(tkn);
+    }
+    void nextSymbol() {
+        symbol = scanner.nextSymbol();
+    }
+    [[noreturn]] void unexpectedSymbol();
 
     // RD parser methods (for each non-terminal in grammar):
     ProgramNode* program();
@@ -44,7 +79,8 @@ private:
     std::vector<VarDeclNode*> variableDeclaration();
     TypeNode* retType();
     TypeNode* varType();
-    TypeNode* type(const SymSet &prefTypes);
+    TypeNode* type(SymSet prefTypes);
+    static Symbol typeSymbol(Token typeToken);
     std::vector<ProcDeclNode*> functionPart();
     ProcDeclNode* functionDeclaration();
     CompoundNode* compoundStatement();
@@ -56,22 +92,19 @@ private:
     IfNode* simpleIfStatement();
     WhileNode* whileStatement();
     Node* expression();
-    Node* simpleExpression();
-    Node* term();
+    Node* expression(int minPower); // precedence climbing over binary operators
     Node* factor();
     VarNode* var();
 
     // subsets of tokens
-    SymSet  relOp,
-            addOp,
-            multOp,
-            sign,
-            varTypes,
-            retTypes,
-            procParams;
+    static constexpr SymSet sign = { PLUS, MINUS };
+    static constexpr SymSet varTypes = { STRINGTYPE, BOOLEANTYPE, INTEGERTYPE, FRACTIONTYPE };
+    static constexpr SymSet retTypes = { VOIDTYPE, STRINGTYPE, BOOLEANTYPE, INTEGERTYPE, FRACTIONTYPE };
+    static constexpr SymSet procParams = { IDENTIFIER, INTCONST, FRACTCONST, CHARCONST };
 
     Scanner &scanner;
     Token symbol;
+    Arena arena; // nodes of tree being built
 };
 
 #endif //FRACTUS_PARSER_H
@@ -0,0 +1,174 @@
+//
+// Inline caches of tree nodes specialized while the program runs
+// Wiktor Franus, WUT 2017
+//
+
+#include "Ast.h"
+#include "Interpreter.h"
+#include "TypedNodes.h"
+
+/**
+ * Quickening: a node starts with a handler which looks at what it gets
+ * on the first evaluation, picks a handler specialized for that and
+ * stores it in the node, so later evaluations go straight to it.
+ * Specialized handlers check their assumption and, when it does not hold,
+ * switch the node to the generic path for good, so a node is specialized
+ * at most once. Operations reuse those of TypedNodes.h, which Specializer
+ * picks ahead of time from static types instead.
+ */
+
+namespace {
+
+/**
+ * Variables, their storage follows from lexical address:
+ * only current and global frames are reachable
+ */
+
+ValType &localVariable(VarNode *node, Interpreter *interpreter) {
+    return interpreter->currContext().getSlots()[node->slot];
+}
+
+ValType &globalVariable(VarNode *node, Interpreter *interpreter) {
+    return interpreter->globalSlots()[node->slot];
+}
+
+/**
+ * Binary operations, for the type of operands seen first
+ */
+
+ValType genericBinary(BinOpNode *node, const ValType &left, const ValType &right) {
+    return Interpreter::binaryOperation(node->op, left, right);
+}
+
+template <typename Op, Type T>
+ValType guardedBinary(BinOpNode *node, const ValType &left, const ValType &right) {
+    if (left.type() != T || right.type() != T) {
+        node->operation = genericBinary;
+        return genericBinary(node, left, right);
+    }
+    return Op::apply(left, right);
+}
+
+template <template <typename> class Comparison, Type T>
+BinOpNode::Operation comparison(Token op) {
+    switch (op) {
+        case EQOP:
+            return guardedBinary<Comparison<std::equal_to<>>, T>;
+        case NEQOP:
+            return guardedBinary<Comparison<std::not_equal_to<>>, T>;
+        case LTOP:
+            return guardedBinary<Comparison<std::less<>>, T>;
+        case LEOP:
+            return guardedBinary<Comparison<std::less_equal<>>, T>;
+        case GTOP:
+            return guardedBinary<Comparison<std::greater<>>, T>;
+        case GEOP:
+            return guardedBinary<Comparison<std::greater_equal<>>, T>;
+        default:
+            return genericBinary;
+    }
+}
+
+BinOpNode::Operation specializedBinary(Token op, Type type) {
+    switch (type) {
+        case Type::Int:
+            switch (op) {
+                case PLUS:
+                    return guardedBinary<IntAdd, Type::Int>;
+                case MINUS:
+                    return guardedBinary<IntSubtract, Type::Int>;
+                case MULTSIGN:
+                    return guardedBinary<IntMultiply, Type::Int>;
+                case DIVSIGN:
+                    return guardedBinary<IntDivide, Type::Int>;
+                default:
+                    return comparison<WordCompare, Type::Int>(op);
+            }
+        case Type::Fraction:
+            switch (op) {
+                case PLUS:
+                    return guardedBinary<FractAdd, Type::Fraction>;
+                case MINUS:
+                    return guardedBinary<FractSubtract, Type::Fraction>;
+                case MULTSIGN:
+                    return guardedBinary<FractMultiply, Type::Fraction>;
+                case DIVSIGN:
+                    return guardedBinary<FractDivide, Type::Fraction>;
+                default:
+                    return comparison<FractCompare, Type::Fraction>(op);
+            }
+        case Type::String:
+            if (op == PLUS) {
+                return guardedBinary<StringConcat, Type::String>;
+            }
+            return comparison<StringCompare, Type::String>(op);
+        case Type::Bool:
+            return comparison<WordCompare, Type::Bool>(op);
+        default:
+            return genericBinary;
+    }
+}
+
+/**
+ * Assignments, to the resolved variable, values of one word
+ * are stored without the generic copy
+ */
+
+void genericStore(AssignNode *node, Interpreter *interpreter, ValType &&value) {
+    interpreter->currContext().getVariableValue(node->left->depth, node->left->slot) = std::move(value);
+}
+
+template <VarNode::Access Variable>
+void storeValue(AssignNode *node, Interpreter *interpreter, ValType &&value) {
+    Variable(node->left, interpreter) = std::move(value);
+}
+
+template <VarNode::Access Variable, Type T>
+void storeWord(AssignNode *node, Interpreter *interpreter, ValType &&value) {
+    if (value.type() != T) {
+        node->store = genericStore;
+        genericStore(node, interpreter, std::move(value));
+        return;
+    }
+    ValType &variable = Variable(node->left, interpreter);
+    if (T == Type::Int) {
+        variable.setInt(value.intVal());
+    } else {
+        variable.setBool(value.boolVal());
+    }
+}
+
+template <VarNode::Access Variable>
+AssignNode::Store specializedStore(Type type) {
+    switch (type) {
+        case Type::Int:
+            return storeWord<Variable, Type::Int>;
+        case Type::Bool:
+            return storeWord<Variable, Type::Bool>;
+        default:
+            return storeValue<Variable>;
+    }
+}
+
+}
+
+ValType quickenBinary(BinOpNode *node, const ValType &left, const ValType &right) {
+    // semantic analysis gives both operands one type
+    node->operation = left.type() == right.type() ? specializedBinary(node->op, left.type()) : genericBinary;
+    return node->operation(node, left, right);
+}
+
+ValType &quickenVariable(VarNode *node, Interpreter *interpreter) {
+    // variables of enclosing scope can only be the global ones
+    node->access = node->depth > 0 ? globalVariable : localVariable;
+    return node->access(node, interpreter);
+}
+
+void quickenAssign(AssignNode *node, Interpreter *interpreter, ValType &&value) {
+    if (node->left->depth > 0) {
+        node->store = specializedStore<globalVariable>(value.type());
+    } else {
+        node->store = specializedStore<localVariable>(value.type());
+    }
+    node->store(node, interpreter, std::move(value));
+}
@@ -3,26 +3,60 @@
 // Wiktor Franus, WUT 2017
 //
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
 #include <iostream>
+#include <iterator>
+
 #include "Reader.h"
-Reader::Reader(const std::string &fileName) {
-    fileStream.open(fileName, std::fstream::in);
-    if (!fileStream.is_open()) {
+
+Reader::Reader(const std::string &fileName)
+: pos(nullptr)
+, limit(nullptr)
+, mapping(nullptr)
+, mappingSize(0)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cout << "Nie mozna otworzyc pliku o nazwie " << fileName << std::endl;
+        return;
     }
-    streamIterator = new std::istreambuf_iterator<char>(fileStream);
-}
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            mapping = p;
+            mappingSize = static_cast<size_t>(st.st_size);
+        }
+    }
+    close(fd);
 
-Reader::~Reader() {
-    delete streamIterator;
-    fileStream.close();
+    if (mapping) {
+        pos = static_cast<const char*>(mapping);
+        limit = pos + mappingSize;
+    } else {
+        // pipes and other special files are read into memory
+        std::ifstream fileStream(fileName, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(fileStream), std::istreambuf_iterator<char>());
+        pos = contents.data();
+        limit = pos + contents.size();
+    }
 }
 
-char Reader::nextChar() {
-    char c = **streamIterator;
-    ++*streamIterator;
-    if (c == '\n') {
-        ++line;
+Reader::Reader(const char *data, size_t size)
+: pos(data)
+, limit(data + size)
+, mapping(nullptr)
+, mappingSize(0)
+{}
+
+Reader::~Reader() {
+    if (mapping) {
+        munmap(mapping, mappingSize);
     }
-    return c;
-}
\ No newline at end of file
+}
@@ -6,21 +6,57 @@
 #ifndef FRACTUS_READER_H
 #define FRACTUS_READER_H
 
-#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <string_view>
 
+/**
+ * Source text kept in one contiguous buffer: a memory mapped file
+ * or memory owned by the caller. Scanner can slice tokens directly
+ * out of it, the buffer lives as long as the Reader.
+ */
 class Reader {
 public:
     Reader(const std::string &fileName);
+    Reader(const char *data, size_t size); // buffer owned by caller
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
     ~Reader();
 
-    char nextChar();
+    char nextChar() {
+        if (pos == limit) {
+            return EOF;
+        }
+        char c = *pos++;
+        if (c == '\n') {
+            ++line;
+        }
+        return c;
+    }
+
+    // next unread char and end of the buffer
+    const char *position() const {
+        return pos;
+    }
+    const char *end() const {
+        return limit;
+    }
+    // moves over chars already examined through position()
+    void skipTo(const char *p) {
+        line += static_cast<int>(std::count(pos, p, '\n'));
+        pos = p;
+    }
 
     int getLine() {
         return line;
     }
 private:
-    std::fstream fileStream;
-    std::istreambuf_iterator<char> *streamIterator;
+    const char *pos;
+    const char *limit;
+    void *mapping;
+    size_t mappingSize;
+    std::string contents; // copy of file which cannot be mapped
     int line = 1;
 };
 
@@ -0,0 +1,139 @@
+//
+// Register machine representation of FraCtuS programs
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_REGISTERCODE_H
+#define FRACTUS_REGISTERCODE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Scope.h"
+
+/**
+ * Registers of a frame are split in banks by static type of their values,
+ * none of them carries a type tag: integers and booleans are machine words,
+ * fractions are BigFractions (inline while they are small), strings are
+ * shared string values.
+ */
+enum class Bank : uint8_t {
+    Int,        // integer and boolean
+    Fraction,
+    String
+};
+
+inline Bank bankOf(Type type) {
+    switch (type) {
+        case Type::Fraction:
+            return Bank::Fraction;
+        case Type::String:
+            return Bank::String;
+        default:
+            return Bank::Int;
+    }
+}
+
+/**
+ * Instruction set. a is the destination register, b and c the sources,
+ * unless stated otherwise. Suffix tells the bank: I - integer, F - fraction,
+ * S - string. Jump targets are indexes of instructions.
+ */
+enum class RegOp : uint8_t {
+    MoveI,          // a = b
+    MoveF,
+    MoveS,
+    GetGlobalI,     // a = global b
+    GetGlobalF,
+    GetGlobalS,
+    SetGlobalI,     // global a = b
+    SetGlobalF,
+    SetGlobalS,
+    AddI,           // a = b op c
+    SubtractI,
+    MultiplyI,
+    DivideI,
+    NegateI,        // a = -b
+    AddF,
+    SubtractF,
+    MultiplyF,
+    DivideF,
+    NegateF,
+    ConcatS,
+    Not,            // a = !b, on booleans
+    EqualI,         // a = b cmp c, result is boolean
+    NotEqualI,
+    LessI,
+    LessEqualI,
+    GreaterI,
+    GreaterEqualI,
+    EqualF,
+    NotEqualF,
+    LessF,
+    LessEqualF,
+    GreaterF,
+    GreaterEqualF,
+    EqualS,
+    NotEqualS,
+    Jump,           // go to c
+    JumpIfFalse,    // go to c if boolean a is false
+    JumpIfTrue,
+    JumpIfEqualI,   // go to c if a cmp b
+    JumpIfNotEqualI,
+    JumpIfLessI,
+    JumpIfLessEqualI,
+    JumpIfGreaterI,
+    JumpIfGreaterEqualI,
+    Call,           // call procedures[a] with arguments listed from arguments[b], result to c
+    TailCall,       // call procedures[a] with arguments from arguments[b] in place of the current frame
+    ReturnI,        // return register a
+    ReturnF,
+    ReturnS,
+    ReturnVoid,
+    MissingReturn,  // end of non-void procedure reached, runtime error
+    Print,          // print register a holding value of type b
+    Read,           // read value of type b into register a
+    Halt
+};
+
+struct RegInstr {
+    RegOp op;
+    uint16_t a;
+    uint16_t b;
+    int32_t c;
+};
+
+/**
+ * Compiled procedure. Registers of each bank are laid out as:
+ * variables (parameters first), constants, temporaries.
+ * Initial values of all of them form the image copied to a new frame,
+ * so constants are never loaded by instructions.
+ */
+struct RegProcedure {
+    struct Param {
+        Type type;
+        uint16_t reg;
+    };
+
+    std::string name;
+    std::vector<RegInstr> code;
+    std::vector<uint16_t> arguments; // registers passed by calls, in order of callee parameters
+    std::vector<Param> params;
+    Type returnType = Type::Void;
+    bool pure = false; // result depends only on arguments, may be memoized
+
+    std::vector<int32_t> ints;
+    std::vector<BigFraction> fractions;
+    std::vector<ValType> strings;
+};
+
+/**
+ * Whole compiled program, registers of main program are the global variables
+ */
+struct RegProgram {
+    RegProcedure main;
+    std::vector<RegProcedure> procedures;
+};
+
+#endif //FRACTUS_REGISTERCODE_H
@@ -0,0 +1,545 @@
+//
+// RegisterCompiler source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "RegisterCompiler.h"
+
+namespace {
+
+/**
+ * Finds literals of a procedure body, they get registers before any code is emitted
+ */
+class ConstantCollector : public Visitor {
+public:
+    ConstantCollector(std::vector<const NumNode*> &constants) : constants(constants) {}
+
+    void visit(const BinOpNode *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const LogicalOp *n) {
+        n->left->accept(*this);
+        n->right->accept(*this);
+    }
+    void visit(const NumNode *n) {
+        constants.push_back(n);
+    }
+    void visit(const UnaryOpNode *n) {
+        n->expression->accept(*this);
+    }
+    void visit(const CompoundNode *n) {
+        for (Node *child : n->children) {
+            child->accept(*this);
+        }
+    }
+    void visit(const AssignNode *n) {
+        n->right->accept(*this);
+    }
+    void visit(const IfNode *n) {
+        n->condition->accept(*this);
+        n->thenNode->accept(*this);
+        if (n->elseNode) {
+            n->elseNode->accept(*this);
+        }
+    }
+    void visit(const WhileNode *n) {
+        n->condition->accept(*this);
+        n->statement->accept(*this);
+    }
+    void visit(const ReturnNode *n) {
+        n->expr->accept(*this);
+    }
+    void visit(const VarNode *n) {}
+    void visit(const ProgramNode *n) {}
+    void visit(const BlockNode *n) {}
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n) {}
+    void visit(const ProcCallNode *n) {
+        for (Node *arg : n->arguments) {
+            arg->accept(*this);
+        }
+    }
+
+private:
+    std::vector<const NumNode*> &constants;
+};
+
+size_t bankSize(const RegProcedure &proc, Bank bank) {
+    switch (bank) {
+        case Bank::Int:
+            return proc.ints.size();
+        case Bank::Fraction:
+            return proc.fractions.size();
+        default:
+            return proc.strings.size();
+    }
+}
+
+// appends register with initial value to its bank
+uint16_t addRegister(RegProcedure &proc, const ValType &value) {
+    size_t reg = bankSize(proc, bankOf(value.type()));
+    if (reg >= std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Too many registers in procedure " + proc.name + ".");
+    }
+    switch (bankOf(value.type())) {
+        case Bank::Int:
+            proc.ints.push_back(value.type() == Type::Void ? 0 : value.intVal());
+            break;
+        case Bank::Fraction:
+            proc.fractions.push_back(value.fractVal());
+            break;
+        case Bank::String:
+            proc.strings.push_back(value);
+            break;
+    }
+    return static_cast<uint16_t>(reg);
+}
+
+// ops of three banks, in order of Bank
+RegOp banked(RegOp intOp, Bank bank) {
+    return static_cast<RegOp>(static_cast<int>(intOp) + static_cast<int>(bank));
+}
+
+RegOp intComparison(Token op) {
+    switch (op) {
+        case EQOP: return RegOp::EqualI;
+        case NEQOP: return RegOp::NotEqualI;
+        case LTOP: return RegOp::LessI;
+        case LEOP: return RegOp::LessEqualI;
+        case GTOP: return RegOp::GreaterI;
+        default: return RegOp::GreaterEqualI;
+    }
+}
+
+// relational operator giving the opposite result
+Token negated(Token op) {
+    switch (op) {
+        case EQOP: return NEQOP;
+        case NEQOP: return EQOP;
+        case LTOP: return GEOP;
+        case LEOP: return GTOP;
+        case GTOP: return LEOP;
+        default: return LTOP;
+    }
+}
+
+bool isComparison(Token op) {
+    return op == EQOP || op == NEQOP || op == LTOP || op == LEOP || op == GTOP || op == GEOP;
+}
+
+// true when evaluation of expression calls a procedure, print and read have no value
+bool callsProcedure(const Node *n) {
+    if (dynamic_cast<const ProcCallNode*>(n)) {
+        return true;
+    }
+    if (const BinOpNode *binOp = dynamic_cast<const BinOpNode*>(n)) {
+        return callsProcedure(binOp->left) || callsProcedure(binOp->right);
+    }
+    if (const UnaryOpNode *unaryOp = dynamic_cast<const UnaryOpNode*>(n)) {
+        return callsProcedure(unaryOp->expression);
+    }
+    return false;
+}
+
+}
+
+RegisterCompiler::RegisterCompiler(Prototypes *prototypes)
+: prototypes(prototypes)
+, program(nullptr)
+, proc(nullptr)
+, inProcedure(false)
+, firstTemporary{}
+, nextTemporary{}
+, temporaryCount{}
+, target(NO_TARGET)
+, result(0)
+{}
+
+RegProgram RegisterCompiler::compile(const ProgramNode *ast) {
+    RegProgram compiled;
+    program = &compiled;
+
+    Scope *globalScope = prototypes->front();
+    compiled.main.name = SymbolTable::name(SYM_GLOBAL);
+    globalRegisters = layoutVariables(globalScope, compiled.main);
+
+    // procedures may be called before their body is compiled (recursion)
+    registerProcedures(ast->block);
+    compiled.procedures.resize(procNodes.size());
+    inProcedure = true;
+    for (size_t i = 0; i < procNodes.size(); ++i) {
+        const ProcDeclNode *n = procNodes[i];
+        RegProcedure &procedure = compiled.procedures[i];
+        Scope *procScope = n->descriptor->scope;
+        procedure.name = SymbolTable::name(n->name);
+        procedure.returnType = valueType(n->returnType->typeName);
+        procedure.pure = n->descriptor->pure;
+
+        localRegisters = layoutVariables(procScope, procedure);
+        // parameters occupy the first slots of the frame
+        for (size_t slot = 0; slot < n->params.size(); ++slot) {
+            Type type = valueType(n->params[slot]->typeNode->typeName);
+            procedure.params.push_back({type, localRegisters[slot]});
+        }
+        compileBody(n->blockNode, procScope, procedure);
+        if (procedure.returnType == Type::Void) {
+            emit(RegOp::ReturnVoid);
+        } else {
+            emit(RegOp::MissingReturn);
+        }
+    }
+
+    // main program frame is the global one
+    inProcedure = false;
+    localRegisters = globalRegisters;
+    compileBody(ast->block, globalScope, compiled.main);
+    emit(RegOp::Halt);
+
+    program = nullptr;
+    proc = nullptr;
+    return compiled;
+}
+
+void RegisterCompiler::registerProcedures(const BlockNode *block) {
+    for (ProcDeclNode *procNode : block->procDeclarations) {
+        procIndexes[procNode] = static_cast<uint16_t>(procNodes.size());
+        procNodes.push_back(procNode);
+        registerProcedures(procNode->blockNode);
+    }
+}
+
+std::vector<uint16_t> RegisterCompiler::layoutVariables(Scope *scope, RegProcedure &procedure) {
+    const std::vector<ValType> &layout = scope->getFrameLayout();
+    std::vector<uint16_t> registers;
+    for (const ValType &value : layout) {
+        registers.push_back(addRegister(procedure, value));
+    }
+    return registers;
+}
+
+void RegisterCompiler::layoutConstants(const BlockNode *block, RegProcedure &procedure) {
+    std::vector<const NumNode*> constants;
+    ConstantCollector collector(constants);
+    block->compundStatement->accept(collector);
+
+    // equal integers and booleans share register
+    std::unordered_map<int32_t, uint16_t> words;
+    constantRegisters.clear();
+    for (const NumNode *n : constants) {
+        if (bankOf(n->constant.type()) == Bank::Int) {
+            auto it = words.find(n->constant.intVal());
+            if (it == words.end()) {
+                it = words.emplace(n->constant.intVal(), addRegister(procedure, n->constant)).first;
+            }
+            constantRegisters[n] = it->second;
+        } else {
+            constantRegisters[n] = addRegister(procedure, n->constant);
+        }
+    }
+}
+
+void RegisterCompiler::compileBody(const BlockNode *block, Scope *scope, RegProcedure &procedure) {
+    proc = &procedure;
+    layoutConstants(block, procedure);
+    firstTemporary[0] = nextTemporary[0] = static_cast<uint16_t>(procedure.ints.size());
+    firstTemporary[1] = nextTemporary[1] = static_cast<uint16_t>(procedure.fractions.size());
+    firstTemporary[2] = nextTemporary[2] = static_cast<uint16_t>(procedure.strings.size());
+    std::fill(temporaryCount, temporaryCount + BANKS, 0);
+
+    block->accept(*this);
+
+    // temporaries start with no value of their own
+    procedure.ints.resize(firstTemporary[0] + temporaryCount[0], 0);
+    procedure.fractions.resize(firstTemporary[1] + temporaryCount[1]);
+    procedure.strings.resize(firstTemporary[2] + temporaryCount[2]);
+}
+
+/**
+ * Registers
+ */
+
+uint16_t RegisterCompiler::expression(const Node *n, int target) {
+    this->target = target;
+    n->accept(*this);
+    this->target = NO_TARGET;
+    return result;
+}
+
+uint16_t RegisterCompiler::operand(const Node *n, bool callFollows) {
+    uint16_t reg = expression(n);
+    // variables of the main program are registers, which a call can change
+    // before the operation reads them
+    if (callFollows && !inProcedure && dynamic_cast<const VarNode*>(n)) {
+        Bank bank = bankOf(n->type);
+        uint16_t copy = temporary(bank);
+        emit(banked(RegOp::MoveI, bank), copy, reg);
+        return copy;
+    }
+    return reg;
+}
+
+uint16_t RegisterCompiler::destination(Type type, int target) {
+    return target != NO_TARGET ? static_cast<uint16_t>(target) : temporary(bankOf(type));
+}
+
+uint16_t RegisterCompiler::temporary(Bank bank) {
+    size_t b = static_cast<size_t>(bank);
+    if (nextTemporary[b] == std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error("Too many registers in procedure " + proc->name + ".");
+    }
+    uint16_t reg = nextTemporary[b]++;
+    if (nextTemporary[b] - firstTemporary[b] > temporaryCount[b]) {
+        temporaryCount[b] = nextTemporary[b] - firstTemporary[b];
+    }
+    return reg;
+}
+
+void RegisterCompiler::statement(const Node *n) {
+    // values of expressions do not outlive their statement
+    uint16_t saved[BANKS];
+    std::copy(nextTemporary, nextTemporary + BANKS, saved);
+    n->accept(*this);
+    std::copy(saved, saved + BANKS, nextTemporary);
+}
+
+bool RegisterCompiler::isGlobal(const VarNode *n) const {
+    // main program frame is the global one
+    return inProcedure && n->depth > 0;
+}
+
+uint16_t RegisterCompiler::globalRegister(const VarNode *n) const {
+    return globalRegisters[n->slot];
+}
+
+/**
+ * Emitting helpers
+ */
+
+size_t RegisterCompiler::emit(RegOp op, uint16_t a, uint16_t b, int32_t c) {
+    proc->code.push_back({op, a, b, c});
+    return proc->code.size() - 1;
+}
+
+void RegisterCompiler::patchJump(size_t jump) {
+    proc->code[jump].c = static_cast<int32_t>(proc->code.size());
+}
+
+size_t RegisterCompiler::branch(const Node *condition, bool when, int32_t target) {
+    // comparison of integers or booleans jumps by itself
+    const BinOpNode *comparison = dynamic_cast<const BinOpNode*>(condition);
+    if (comparison && !dynamic_cast<const LogicalOp*>(condition) && isComparison(comparison->op)
+        && bankOf(comparison->left->type) == Bank::Int) {
+        uint16_t left = operand(comparison->left, callsProcedure(comparison->right));
+        uint16_t right = expression(comparison->right);
+        Token op = when ? comparison->op : negated(comparison->op);
+        RegOp jump = static_cast<RegOp>(static_cast<int>(RegOp::JumpIfEqualI)
+                                        + static_cast<int>(intComparison(op)) - static_cast<int>(RegOp::EqualI));
+        return emit(jump, left, right, target);
+    }
+    uint16_t value = expression(condition);
+    return emit(when ? RegOp::JumpIfTrue : RegOp::JumpIfFalse, value, 0, target);
+}
+
+/**
+ * Visitor methods
+ */
+
+void RegisterCompiler::visit(const BlockNode *n) {
+    // nested procedures are compiled separately
+    n->compundStatement->accept(*this);
+}
+
+void RegisterCompiler::visit(const CompoundNode *n) {
+    for (Node *child : n->children) {
+        statement(child);
+    }
+}
+
+void RegisterCompiler::visit(const NumNode *n) {
+    result = constantRegisters.at(n);
+}
+
+void RegisterCompiler::visit(const VarNode *n) {
+    if (isGlobal(n)) {
+        uint16_t reg = destination(n->type, target);
+        emit(banked(RegOp::GetGlobalI, bankOf(n->type)), reg, globalRegister(n));
+        result = reg;
+        return;
+    }
+    result = localRegisters[n->slot];
+}
+
+void RegisterCompiler::visit(const BinOpNode *n) {
+    int resultTarget = target;
+    uint16_t left = operand(n->left, callsProcedure(n->right));
+    uint16_t right = expression(n->right);
+    Bank bank = bankOf(n->left->type);
+
+    RegOp op;
+    if (isComparison(n->op)) {
+        if (bank == Bank::Int) {
+            op = intComparison(n->op);
+        } else if (bank == Bank::Fraction) {
+            op = static_cast<RegOp>(static_cast<int>(RegOp::EqualF)
+                                    + static_cast<int>(intComparison(n->op)) - static_cast<int>(RegOp::EqualI));
+        } else {
+            op = n->op == EQOP ? RegOp::EqualS : RegOp::NotEqualS;
+        }
+    } else if (bank == Bank::String) {
+        op = RegOp::ConcatS;
+    } else {
+        RegOp first = bank == Bank::Int ? RegOp::AddI : RegOp::AddF;
+        int offset = n->op == PLUS ? 0 : n->op == MINUS ? 1 : n->op == MULTSIGN ? 2 : 3;
+        op = static_cast<RegOp>(static_cast<int>(first) + offset);
+    }
+
+    result = destination(n->type, resultTarget);
+    emit(op, result, left, right);
+}
+
+void RegisterCompiler::visit(const LogicalOp *n) {
+    // target could be read by the right operand after the left one is stored
+    uint16_t reg = temporary(Bank::Int);
+    uint16_t left = expression(n->left, reg);
+    if (left != reg) {
+        emit(RegOp::MoveI, reg, left);
+    }
+    size_t shortCircuit = emit(n->op == OROP ? RegOp::JumpIfTrue : RegOp::JumpIfFalse, reg);
+    uint16_t right = expression(n->right, reg);
+    if (right != reg) {
+        emit(RegOp::MoveI, reg, right);
+    }
+    patchJump(shortCircuit);
+    result = reg;
+}
+
+void RegisterCompiler::visit(const UnaryOpNode *n) {
+    int resultTarget = target;
+    uint16_t operand = expression(n->expression);
+    result = destination(n->type, resultTarget);
+    if (n->op == NOTSIGN) {
+        emit(RegOp::Not, result, operand);
+    } else {
+        emit(n->type == Type::Int ? RegOp::NegateI : RegOp::NegateF, result, operand);
+    }
+}
+
+void RegisterCompiler::visit(const AssignNode *n) {
+    Bank bank = bankOf(n->left->type);
+    if (isGlobal(n->left)) {
+        uint16_t value = expression(n->right);
+        emit(banked(RegOp::SetGlobalI, bank), globalRegister(n->left), value);
+        return;
+    }
+    uint16_t variable = localRegisters[n->left->slot];
+    uint16_t value = expression(n->right, variable);
+    if (value != variable) {
+        emit(banked(RegOp::MoveI, bank), variable, value);
+    }
+}
+
+void RegisterCompiler::visit(const IfNode *n) {
+    size_t elseJump = branch(n->condition, false, 0);
+    statement(n->thenNode);
+    if (n->elseNode) {
+        size_t endJump = emit(RegOp::Jump);
+        patchJump(elseJump);
+        statement(n->elseNode);
+        patchJump(endJump);
+    } else {
+        patchJump(elseJump);
+    }
+}
+
+void RegisterCompiler::visit(const WhileNode *n) {
+    // condition is placed after the body, one jump per iteration
+    size_t conditionJump = emit(RegOp::Jump);
+    int32_t bodyStart = static_cast<int32_t>(proc->code.size());
+    statement(n->statement);
+    patchJump(conditionJump);
+    uint16_t saved[BANKS];
+    std::copy(nextTemporary, nextTemporary + BANKS, saved);
+    branch(n->condition, true, bodyStart);
+    std::copy(saved, saved + BANKS, nextTemporary);
+}
+
+void RegisterCompiler::visit(const ReturnNode *n) {
+    if (!inProcedure) {
+        // return from main program ends it
+        expression(n->expr);
+        emit(RegOp::Halt);
+        return;
+    }
+    if (n->tailCall) {
+        // callee returns directly to our caller
+        call(n->tailCall, RegOp::TailCall, NO_TARGET);
+        return;
+    }
+    uint16_t value = expression(n->expr);
+    switch (bankOf(n->expr->type)) {
+        case Bank::Int:
+            emit(RegOp::ReturnI, value);
+            break;
+        case Bank::Fraction:
+            emit(RegOp::ReturnF, value);
+            break;
+        case Bank::String:
+            emit(RegOp::ReturnS, value);
+            break;
+    }
+}
+
+void RegisterCompiler::visit(const ProcCallNode *n) {
+    int resultTarget = target;
+    // builtin procedures, values are tagged with their type only here
+    if (n->builtin == builtinPrint) {
+        const Node *arg = n->arguments[0];
+        emit(RegOp::Print, expression(arg), static_cast<uint16_t>(arg->type));
+        return;
+    }
+    if (n->builtin == builtinRead) {
+        const VarNode *varNode = static_cast<const VarNode*>(n->arguments[0]);
+        uint16_t type = static_cast<uint16_t>(varNode->type);
+        if (isGlobal(varNode)) {
+            // read keeps the old value when input is not valid
+            uint16_t reg = expression(varNode);
+            emit(RegOp::Read, reg, type);
+            emit(banked(RegOp::SetGlobalI, bankOf(varNode->type)), globalRegister(varNode), reg);
+        } else {
+            emit(RegOp::Read, localRegisters[varNode->slot], type);
+        }
+        return;
+    }
+    result = call(n, RegOp::Call, resultTarget);
+}
+
+uint16_t RegisterCompiler::call(const ProcCallNode *n, RegOp op, int target) {
+    auto it = procIndexes.find(n->descriptor->declaration);
+    if (it == procIndexes.end()) {
+        throw std::runtime_error("Cannot find declared procedure: " + SymbolTable::name(n->proc->name));
+    }
+    std::vector<uint16_t> args;
+    for (size_t i = 0; i < n->arguments.size(); ++i) {
+        bool callFollows = std::any_of(n->arguments.begin() + i + 1, n->arguments.end(), callsProcedure);
+        args.push_back(operand(n->arguments[i], callFollows));
+    }
+    if (proc->arguments.size() > static_cast<size_t>(std::numeric_limits<uint16_t>::max())) {
+        throw std::runtime_error("Too many calls in procedure " + proc->name + ".");
+    }
+    uint16_t argsStart = static_cast<uint16_t>(proc->arguments.size());
+    proc->arguments.insert(proc->arguments.end(), args.begin(), args.end());
+
+    uint16_t reg = 0;
+    if (op == RegOp::Call && n->type != Type::Void) {
+        reg = destination(n->type, target);
+    }
+    emit(op, it->second, argsStart, reg);
+    return reg;
+}
@@ -0,0 +1,88 @@
+//
+// Compiler of checked AST to register machine code
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_REGISTERCOMPILER_H
+#define FRACTUS_REGISTERCOMPILER_H
+
+#include <unordered_map>
+
+#include "Ast.h"
+#include "RegisterCode.h"
+
+/**
+ * Tree visitor emitting code for register machine.
+ * Variables and constants get registers of their own, expressions
+ * are computed into temporaries freed after every statement.
+ * Expects AST already checked by SemanticAnalyzer.
+ */
+class RegisterCompiler : public Visitor {
+public:
+    using Prototypes = std::vector<Scope*>; // global scope first, then procedure scopes
+    RegisterCompiler(Prototypes *prototypes);
+
+    RegProgram compile(const ProgramNode *ast);
+
+    void visit(const BinOpNode *n);
+    void visit(const LogicalOp *n);
+    void visit(const NumNode *n);
+    void visit(const UnaryOpNode *n);
+    void visit(const CompoundNode *n);
+    void visit(const AssignNode *n);
+    void visit(const IfNode *n);
+    void visit(const WhileNode *n);
+    void visit(const ReturnNode *n);
+    void visit(const VarNode *n);
+    void visit(const ProgramNode *n) {}
+    void visit(const BlockNode *n);
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n) {}
+    void visit(const ProcCallNode *n);
+
+private:
+    static const int NO_TARGET = -1;
+    static const size_t BANKS = 3;
+
+    void registerProcedures(const BlockNode *block);
+    void compileBody(const BlockNode *block, Scope *scope, RegProcedure &proc);
+    std::vector<uint16_t> layoutVariables(Scope *scope, RegProcedure &proc);
+    void layoutConstants(const BlockNode *block, RegProcedure &proc);
+
+    // register holding value of expression, computed into target if it can be
+    uint16_t expression(const Node *n, int target = NO_TARGET);
+    // value of operand, kept from calls in operands computed after it
+    uint16_t operand(const Node *n, bool callFollows);
+    uint16_t destination(Type type, int target);
+    uint16_t temporary(Bank bank);
+    void statement(const Node *n);
+    bool isGlobal(const VarNode *n) const;
+    uint16_t globalRegister(const VarNode *n) const;
+    uint16_t call(const ProcCallNode *n, RegOp op, int target);
+    // conditional jump to target taken when condition has given value
+    size_t branch(const Node *condition, bool when, int32_t target);
+
+    size_t emit(RegOp op, uint16_t a = 0, uint16_t b = 0, int32_t c = 0);
+    void patchJump(size_t jump);
+
+    Prototypes *prototypes;
+    RegProgram *program;
+    RegProcedure *proc;   // procedure being currently emitted
+    bool inProcedure;
+    std::unordered_map<const ProcDeclNode*, uint16_t> procIndexes;
+    std::vector<const ProcDeclNode*> procNodes;
+
+    std::vector<uint16_t> localRegisters;  // by slot of variable in current frame
+    std::vector<uint16_t> globalRegisters; // by slot of global variable
+    std::unordered_map<const NumNode*, uint16_t> constantRegisters;
+    uint16_t firstTemporary[BANKS];
+    uint16_t nextTemporary[BANKS];
+    uint16_t temporaryCount[BANKS];
+
+    int target;      // register the expression being visited may write its result to
+    uint16_t result; // register of value of expression just visited
+};
+
+#endif //FRACTUS_REGISTERCOMPILER_H
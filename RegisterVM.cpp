@@ -0,0 +1,476 @@
+//
+// RegisterVM source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "RegisterVM.h"
+#include "Interpreter.h"
+#include "Numeric.h"
+
+// labels as values are a GCC and Clang extension, elsewhere instructions are dispatched by switch
+#if defined(__GNUC__) && !defined(FRACTUS_SWITCH_DISPATCH)
+#define FRACTUS_COMPUTED_GOTO
+#endif
+
+// initial sizes, all grow twice when they are full
+static const size_t INITIAL_INTS = 4096;
+static const size_t INITIAL_OBJECTS = 256;
+static const size_t INITIAL_FRAMES = 256;
+
+RegisterVM::RegisterVM(Interpreter *interpreter, const RegProgram &program, size_t stackMemory, bool compile)
+: interpreter(interpreter)
+, program(program)
+, ints(INITIAL_INTS)
+, fractions(INITIAL_OBJECTS)
+, strings(INITIAL_OBJECTS)
+, stackMemory(stackMemory)
+, memo(interpreter->getMemo())
+, jit(compile ? new JitCompiler(program, memo != nullptr) : nullptr)
+{
+    frames.reserve(INITIAL_FRAMES);
+}
+
+bool RegisterVM::fits(size_t intCount, size_t fractionCount, size_t stringCount, size_t frameCount) const {
+    return intCount * sizeof(int32_t) + fractionCount * sizeof(BigFraction)
+           + stringCount * sizeof(ValType) + frameCount * sizeof(Frame) <= stackMemory;
+}
+
+void RegisterVM::reserve(size_t intBase, size_t fractionBase, size_t stringBase, const RegProcedure &proc) {
+    size_t intTop = intBase + proc.ints.size();
+    size_t fractionTop = fractionBase + proc.fractions.size();
+    size_t stringTop = stringBase + proc.strings.size();
+    if (intTop <= ints.size() && fractionTop <= fractions.size() && stringTop <= strings.size()
+        && frames.size() < frames.capacity()) {
+        return;
+    }
+
+    size_t intCount = intTop <= ints.size() ? ints.size() : std::max(ints.size() * 2, intTop);
+    size_t fractionCount = fractionTop <= fractions.size() ? fractions.size()
+                                                           : std::max(fractions.size() * 2, fractionTop);
+    size_t stringCount = stringTop <= strings.size() ? strings.size() : std::max(strings.size() * 2, stringTop);
+    size_t frameCount = frames.size() < frames.capacity() ? frames.capacity() : frames.capacity() * 2;
+    if (!fits(intCount, fractionCount, stringCount, frameCount)) {
+        // close to the limit everything which has to grow is scaled down together
+        // to the largest size fitting the limit, so it grows once more, not per call
+        size_t intNeeded = std::max(ints.size(), intTop);
+        size_t fractionNeeded = std::max(fractions.size(), fractionTop);
+        size_t stringNeeded = std::max(strings.size(), stringTop);
+        size_t frameNeeded = std::max(frames.capacity(), frames.size() + 1);
+        if (!fits(intNeeded, fractionNeeded, stringNeeded, frameNeeded)) {
+            throw std::runtime_error("Stack overflow in procedure: " + proc.name);
+        }
+        // binary search of the part of doubled growth that fits
+        size_t low = 0, high = 1024;
+        auto scaled = [](size_t needed, size_t doubled, size_t part) {
+            return needed + (doubled - needed) * part / 1024;
+        };
+        while (low < high) {
+            size_t part = (low + high + 1) / 2;
+            if (fits(scaled(intNeeded, intCount, part), scaled(fractionNeeded, fractionCount, part),
+                     scaled(stringNeeded, stringCount, part), scaled(frameNeeded, frameCount, part))) {
+                low = part;
+            } else {
+                high = part - 1;
+            }
+        }
+        intCount = scaled(intNeeded, intCount, low);
+        fractionCount = scaled(fractionNeeded, fractionCount, low);
+        stringCount = scaled(stringNeeded, stringCount, low);
+        frameCount = scaled(frameNeeded, frameCount, low);
+    }
+    // frames refer to registers by position, so banks may move
+    ints.resize(intCount);
+    fractions.resize(fractionCount);
+    strings.resize(stringCount);
+    frames.reserve(frameCount);
+}
+
+void RegisterVM::enter(const RegProcedure &proc, size_t intBase, size_t fractionBase, size_t stringBase) {
+    std::copy(proc.ints.begin(), proc.ints.end(), ints.begin() + intBase);
+    std::copy(proc.fractions.begin(), proc.fractions.end(), fractions.begin() + fractionBase);
+    std::copy(proc.strings.begin(), proc.strings.end(), strings.begin() + stringBase);
+}
+
+ValType RegisterVM::boxInt(Type type, int32_t value) {
+    return type == Type::Bool ? ValType::fromBool(value != 0) : ValType::fromInt(value);
+}
+
+ValType RegisterVM::box(Type type, const Frame &frame, uint16_t reg) const {
+    switch (type) {
+        case Type::Bool:
+        case Type::Int:
+            return boxInt(type, ints[frame.ints + reg]);
+        case Type::Fraction:
+            return ValType::fromFraction(fractions[frame.fractions + reg]);
+        case Type::String:
+            return strings[frame.strings + reg];
+        default:
+            return ValType();
+    }
+}
+
+void RegisterVM::unbox(const ValType &value, Type type, const Frame &frame, uint16_t reg) {
+    switch (bankOf(type)) {
+        case Bank::Int:
+            ints[frame.ints + reg] = value.intVal();
+            break;
+        case Bank::Fraction:
+            fractions[frame.fractions + reg] = value.fractVal();
+            break;
+        case Bank::String:
+            strings[frame.strings + reg] = value;
+            break;
+    }
+}
+
+void RegisterVM::deoptimize() {
+    std::vector<DeoptFrame> &exits = jit->getExits();
+    // outermost is the frame native code was entered for, procedure may differ after tail calls
+    frames.back().proc = exits.back().proc;
+    frames.back().ip = exits.back().proc->code.data() + exits.back().ip;
+    for (size_t i = exits.size() - 1; i-- > 0;) {
+        const DeoptFrame &exit = exits[i];
+        size_t intBase = static_cast<size_t>(exit.regs - ints.data());
+        const Frame &caller = frames.back();
+        size_t fractionBase = caller.fractions + caller.proc->fractions.size();
+        size_t stringBase = caller.strings + caller.proc->strings.size();
+        uint16_t result = static_cast<uint16_t>(exits[i + 1].result);
+        // registers are set already, native code called only procedures with integer registers
+        reserve(intBase, fractionBase, stringBase, *exit.proc);
+        frames.push_back({exit.proc, exit.proc->code.data() + exit.ip, intBase, fractionBase, stringBase,
+                          result, nullptr});
+    }
+    exits.clear();
+}
+
+void RegisterVM::run() {
+    const RegProcedure *current = &program.main;
+    reserve(0, 0, 0, *current);
+    enter(*current, 0, 0, 0);
+    frames.push_back({current, nullptr, 0, 0, 0, 0, nullptr});
+
+    const RegInstr *code = current->code.data();
+    const RegInstr *ip = code;
+    JitCompiler *compiler = jit.get();
+    const void *nativeEntry = nullptr;
+    int32_t *I, *GI;
+    BigFraction *F, *GF;
+    ValType *S, *GS;
+
+// registers of the current frame and global ones, after a call or growth of banks
+#define LOAD_FRAME()                                                        \
+    do {                                                                    \
+        const Frame &frame = frames.back();                                 \
+        I = ints.data() + frame.ints;                                       \
+        F = fractions.data() + frame.fractions;                             \
+        S = strings.data() + frame.strings;                                 \
+        GI = ints.data();                                                   \
+        GF = fractions.data();                                              \
+        GS = strings.data();                                                \
+    } while (false)
+
+    LOAD_FRAME();
+
+#ifdef FRACTUS_COMPUTED_GOTO
+    // threaded code: every instruction jumps straight to the next one's handler
+    static void *const handlers[] = {
+        &&op_MoveI, &&op_MoveF, &&op_MoveS,
+        &&op_GetGlobalI, &&op_GetGlobalF, &&op_GetGlobalS,
+        &&op_SetGlobalI, &&op_SetGlobalF, &&op_SetGlobalS,
+        &&op_AddI, &&op_SubtractI, &&op_MultiplyI, &&op_DivideI, &&op_NegateI,
+        &&op_AddF, &&op_SubtractF, &&op_MultiplyF, &&op_DivideF, &&op_NegateF,
+        &&op_ConcatS,
+        &&op_Not,
+        &&op_EqualI, &&op_NotEqualI, &&op_LessI, &&op_LessEqualI, &&op_GreaterI, &&op_GreaterEqualI,
+        &&op_EqualF, &&op_NotEqualF, &&op_LessF, &&op_LessEqualF, &&op_GreaterF, &&op_GreaterEqualF,
+        &&op_EqualS, &&op_NotEqualS,
+        &&op_Jump, &&op_JumpIfFalse, &&op_JumpIfTrue,
+        &&op_JumpIfEqualI, &&op_JumpIfNotEqualI, &&op_JumpIfLessI,
+        &&op_JumpIfLessEqualI, &&op_JumpIfGreaterI, &&op_JumpIfGreaterEqualI,
+        &&op_Call, &&op_TailCall,
+        &&op_ReturnI, &&op_ReturnF, &&op_ReturnS, &&op_ReturnVoid,
+        &&op_MissingReturn,
+        &&op_Print, &&op_Read,
+        &&op_Halt
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(RegOp::Halt) + 1,
+                  "handler for every opcode, in order of RegOp");
+#define CASE(op) op_##op
+#define DISPATCH() goto *handlers[static_cast<uint8_t>(ip->op)]
+    DISPATCH();
+    {
+        {
+#else
+#define CASE(op) case RegOp::op
+#define DISPATCH() goto dispatch
+    dispatch:
+    {
+        switch (ip->op) {
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (false)
+#define JUMP(target) do { ip = code + (target); DISPATCH(); } while (false)
+#define BINARY(bank, expr) do { bank[ip->a] = (expr); NEXT(); } while (false)
+#define JUMP_IF(condition) do { if (condition) BRANCH(ip->c); NEXT(); } while (false)
+
+// continues with instruction and registers of the frame on top
+#define RESUME()                                                            \
+    do {                                                                    \
+        current = frames.back().proc;                                       \
+        code = current->code.data();                                        \
+        ip = frames.back().ip;                                              \
+        LOAD_FRAME();                                                       \
+        DISPATCH();                                                         \
+    } while (false)
+
+// leaves the frame: result is cached for memoized call, execution goes back to caller
+#define RETURN(value, boxed)                                                \
+    do {                                                                    \
+        const Frame &frame = frames.back();                                 \
+        if (frame.memoized) {                                               \
+            size_t count = frame.memoized->params.size();                   \
+            memo->insert(frame.memoized, memoArgs.data() + memoArgs.size() - count, \
+                         count, boxed);                                     \
+            memoArgs.resize(memoArgs.size() - count);                       \
+        }                                                                   \
+        uint16_t result = frame.result;                                     \
+        value;                                                              \
+        frames.pop_back();                                                  \
+        RESUME();                                                           \
+    } while (false)
+
+// jump back counts for JIT, a loop which is hot enough continues as machine code
+#define BRANCH(target)                                                      \
+    do {                                                                    \
+        if (compiler && code + (target) <= ip) {                            \
+            nativeEntry = compiler->hotLoop(*current, (target));            \
+            if (nativeEntry) {                                              \
+                goto enterNative;                                           \
+            }                                                               \
+        }                                                                   \
+        JUMP(target);                                                       \
+    } while (false)
+
+            CASE(MoveI): BINARY(I, I[ip->b]);
+            CASE(MoveF): BINARY(F, F[ip->b]);
+            CASE(MoveS): BINARY(S, S[ip->b]);
+            CASE(GetGlobalI): BINARY(I, GI[ip->b]);
+            CASE(GetGlobalF): BINARY(F, GF[ip->b]);
+            CASE(GetGlobalS): BINARY(S, GS[ip->b]);
+            CASE(SetGlobalI): BINARY(GI, I[ip->b]);
+            CASE(SetGlobalF): BINARY(GF, F[ip->b]);
+            CASE(SetGlobalS): BINARY(GS, S[ip->b]);
+
+            CASE(AddI): BINARY(I, I[ip->b] + I[ip->c]);
+            CASE(SubtractI): BINARY(I, I[ip->b] - I[ip->c]);
+            CASE(MultiplyI): BINARY(I, I[ip->b] * I[ip->c]);
+            CASE(DivideI):
+                if (I[ip->c] == 0) {
+                    throw std::runtime_error("Operand must be different than 0.");
+                }
+                BINARY(I, wrappingDivide(I[ip->b], I[ip->c]));
+            CASE(NegateI): BINARY(I, -I[ip->b]);
+            CASE(AddF): BINARY(F, F[ip->b] + F[ip->c]);
+            CASE(SubtractF): BINARY(F, F[ip->b] - F[ip->c]);
+            CASE(MultiplyF): BINARY(F, F[ip->b] * F[ip->c]);
+            CASE(DivideF):
+                if (F[ip->c].isZero()) {
+                    throw std::runtime_error("Operand must be different than 0.");
+                }
+                BINARY(F, F[ip->b] / F[ip->c]);
+            CASE(NegateF): BINARY(F, -F[ip->b]);
+            CASE(ConcatS): BINARY(S, ValType::fromString(S[ip->b].stringVal() + S[ip->c].stringVal()));
+            CASE(Not): BINARY(I, !I[ip->b]);
+
+            CASE(EqualI): BINARY(I, I[ip->b] == I[ip->c]);
+            CASE(NotEqualI): BINARY(I, I[ip->b] != I[ip->c]);
+            CASE(LessI): BINARY(I, I[ip->b] < I[ip->c]);
+            CASE(LessEqualI): BINARY(I, I[ip->b] <= I[ip->c]);
+            CASE(GreaterI): BINARY(I, I[ip->b] > I[ip->c]);
+            CASE(GreaterEqualI): BINARY(I, I[ip->b] >= I[ip->c]);
+            CASE(EqualF): BINARY(I, F[ip->b] == F[ip->c]);
+            CASE(NotEqualF): BINARY(I, F[ip->b] != F[ip->c]);
+            CASE(LessF): BINARY(I, F[ip->b] < F[ip->c]);
+            CASE(LessEqualF): BINARY(I, F[ip->b] <= F[ip->c]);
+            CASE(GreaterF): BINARY(I, F[ip->b] > F[ip->c]);
+            CASE(GreaterEqualF): BINARY(I, F[ip->b] >= F[ip->c]);
+            CASE(EqualS): BINARY(I, S[ip->b].stringVal() == S[ip->c].stringVal());
+            CASE(NotEqualS): BINARY(I, S[ip->b].stringVal() != S[ip->c].stringVal());
+
+            CASE(Jump): BRANCH(ip->c);
+            CASE(JumpIfFalse): JUMP_IF(!I[ip->a]);
+            CASE(JumpIfTrue): JUMP_IF(I[ip->a]);
+            CASE(JumpIfEqualI): JUMP_IF(I[ip->a] == I[ip->b]);
+            CASE(JumpIfNotEqualI): JUMP_IF(I[ip->a] != I[ip->b]);
+            CASE(JumpIfLessI): JUMP_IF(I[ip->a] < I[ip->b]);
+            CASE(JumpIfLessEqualI): JUMP_IF(I[ip->a] <= I[ip->b]);
+            CASE(JumpIfGreaterI): JUMP_IF(I[ip->a] > I[ip->b]);
+            CASE(JumpIfGreaterEqualI): JUMP_IF(I[ip->a] >= I[ip->b]);
+
+            CASE(Call): {
+                const RegProcedure &callee = program.procedures[ip->a];
+                const uint16_t *args = current->arguments.data() + ip->b;
+                const Frame &caller = frames.back();
+
+                const RegProcedure *memoized = nullptr;
+                if (memo && callee.pure) {
+                    // values are tagged only to look them up
+                    boxedArgs.clear();
+                    for (size_t i = 0; i < callee.params.size(); ++i) {
+                        boxedArgs.push_back(box(callee.params[i].type, caller, args[i]));
+                    }
+                    const ValType *cached = memo->find(&callee, boxedArgs.data(), boxedArgs.size());
+                    if (cached) {
+                        if (callee.returnType != Type::Void) {
+                            unbox(*cached, callee.returnType, caller, static_cast<uint16_t>(ip->c));
+                        }
+                        NEXT();
+                    }
+                    memoArgs.insert(memoArgs.end(), boxedArgs.begin(), boxedArgs.end());
+                    memoized = &callee;
+                }
+
+                size_t intBase = caller.ints + current->ints.size();
+                size_t fractionBase = caller.fractions + current->fractions.size();
+                size_t stringBase = caller.strings + current->strings.size();
+                reserve(intBase, fractionBase, stringBase, callee);
+                LOAD_FRAME();
+                enter(callee, intBase, fractionBase, stringBase);
+
+                // arguments become parameters
+                for (size_t i = 0; i < callee.params.size(); ++i) {
+                    uint16_t reg = callee.params[i].reg;
+                    switch (bankOf(callee.params[i].type)) {
+                        case Bank::Int:
+                            ints[intBase + reg] = I[args[i]];
+                            break;
+                        case Bank::Fraction:
+                            fractions[fractionBase + reg] = F[args[i]];
+                            break;
+                        case Bank::String:
+                            strings[stringBase + reg] = S[args[i]];
+                            break;
+                    }
+                }
+
+                frames.back().ip = ip + 1;
+                frames.push_back({&callee, nullptr, intBase, fractionBase, stringBase,
+                                  static_cast<uint16_t>(ip->c), memoized});
+                current = &callee;
+                code = current->code.data();
+                LOAD_FRAME();
+                if (compiler && compiler->hotCall(callee)) {
+                    nativeEntry = nullptr;
+                    goto enterNative;
+                }
+                JUMP(0);
+            }
+            CASE(TailCall): {
+                const RegProcedure &callee = program.procedures[ip->a];
+                const uint16_t *args = current->arguments.data() + ip->b;
+                tailInts.clear();
+                tailFractions.clear();
+                tailStrings.clear();
+                for (size_t i = 0; i < callee.params.size(); ++i) {
+                    switch (bankOf(callee.params[i].type)) {
+                        case Bank::Int:
+                            tailInts.push_back(I[args[i]]);
+                            break;
+                        case Bank::Fraction:
+                            tailFractions.push_back(F[args[i]]);
+                            break;
+                        case Bank::String:
+                            tailStrings.push_back(S[args[i]]);
+                            break;
+                    }
+                }
+
+                // callee takes over the frame, it returns to our caller
+                // reserve() may move frames, so bases are copied first
+                size_t intBase = frames.back().ints;
+                size_t fractionBase = frames.back().fractions;
+                size_t stringBase = frames.back().strings;
+                reserve(intBase, fractionBase, stringBase, callee);
+                enter(callee, intBase, fractionBase, stringBase);
+                LOAD_FRAME();
+                size_t nextInt = 0, nextFraction = 0, nextString = 0;
+                for (const RegProcedure::Param &param : callee.params) {
+                    switch (bankOf(param.type)) {
+                        case Bank::Int:
+                            I[param.reg] = tailInts[nextInt++];
+                            break;
+                        case Bank::Fraction:
+                            F[param.reg] = std::move(tailFractions[nextFraction++]);
+                            break;
+                        case Bank::String:
+                            S[param.reg] = std::move(tailStrings[nextString++]);
+                            break;
+                    }
+                }
+
+                frames.back().proc = &callee;
+                current = &callee;
+                code = current->code.data();
+                if (compiler && compiler->hotCall(callee)) {
+                    nativeEntry = nullptr;
+                    goto enterNative;
+                }
+                JUMP(0);
+            }
+
+
+            CASE(ReturnI): RETURN(ints[frames[frames.size() - 2].ints + result] = I[ip->a],
+                                  box(current->returnType, frame, ip->a));
+            CASE(ReturnF): RETURN(fractions[frames[frames.size() - 2].fractions + result] = F[ip->a],
+                                  box(Type::Fraction, frame, ip->a));
+            CASE(ReturnS): RETURN(strings[frames[frames.size() - 2].strings + result] = S[ip->a],
+                                  box(Type::String, frame, ip->a));
+            CASE(ReturnVoid): RETURN((void)result, ValType());
+            CASE(MissingReturn):
+                throw std::runtime_error("Procedure " + current->name + " ended without returning a value.");
+
+            CASE(Print):
+                std::cout << box(static_cast<Type>(ip->b), frames.back(), ip->a) << std::endl;
+                NEXT();
+            CASE(Read): {
+                // input is parsed as value of the register's type
+                Type type = static_cast<Type>(ip->b);
+                ValType value = box(type, frames.back(), ip->a);
+                std::cin >> value;
+                unbox(value, type, frames.back(), ip->a);
+            }
+                // computed goto would not destroy value
+                NEXT();
+            CASE(Halt):
+                return;
+
+            // the frame on top runs as machine code from nativeEntry, then continues where it stopped
+            enterNative: {
+                NativeStatus status = compiler->run(*current, I, GI, ints.data() + ints.size(), nativeEntry);
+                if (status == NativeStatus::Exited) {
+                    deoptimize();
+                    RESUME();
+                }
+                int32_t value = compiler->getResult();
+                if (status == NativeStatus::Returned) {
+                    RETURN(ints[frames[frames.size() - 2].ints + result] = value,
+                           boxInt(frame.memoized->returnType, value));
+                }
+                RETURN((void)result, ValType());
+            }
+        }
+    }
+
+#undef BRANCH
+#undef RETURN
+#undef RESUME
+#undef JUMP_IF
+#undef BINARY
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
+#undef CASE
+#undef LOAD_FRAME
+}
@@ -0,0 +1,69 @@
+//
+// Register machine executing FraCtuS register code
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_REGISTERVM_H
+#define FRACTUS_REGISTERVM_H
+
+#include <memory>
+
+#include "JitCompiler.h"
+#include "MemoCache.h"
+#include "RegisterCode.h"
+
+class Interpreter;
+
+/**
+ * Executor of register code. Registers of a call are kept in three
+ * heap allocated banks of untagged values, one per bank of RegProcedure.
+ * Banks and frames grow on demand up to the memory limit.
+ * With JIT hot procedures and loops run as machine code on the same registers.
+ */
+class RegisterVM {
+public:
+    RegisterVM(Interpreter *interpreter, const RegProgram &program, size_t stackMemory, bool compile = false);
+    void run();
+
+private:
+    struct Frame {
+        const RegProcedure *proc;
+        const RegInstr *ip;     // return address when frame is suspended by a call
+        size_t ints;            // first registers of the frame in banks
+        size_t fractions;
+        size_t strings;
+        uint16_t result;        // register of caller receiving returned value
+        const RegProcedure *memoized; // call whose result is cached when it returns
+    };
+
+    // makes room for registers of proc starting at given positions and for one more frame
+    void reserve(size_t ints, size_t fractions, size_t strings, const RegProcedure &proc);
+    bool fits(size_t intCount, size_t fractionCount, size_t stringCount, size_t frameCount) const;
+    // registers of proc set to its initial image
+    void enter(const RegProcedure &proc, size_t ints, size_t fractions, size_t strings);
+    ValType box(Type type, const Frame &frame, uint16_t reg) const;
+    static ValType boxInt(Type type, int32_t value);
+    void unbox(const ValType &value, Type type, const Frame &frame, uint16_t reg);
+    // calls native code was making become frames of the VM, the innermost one is continued
+    void deoptimize();
+
+    Interpreter *interpreter;
+    const RegProgram &program;
+    std::vector<int32_t> ints;
+    std::vector<BigFraction> fractions;
+    std::vector<ValType> strings;
+    std::vector<Frame> frames;
+    size_t stackMemory; // limit of bytes taken by banks and frames together
+
+    MemoCache *memo;
+    std::vector<ValType> memoArgs; // arguments of memoized calls in progress
+    std::vector<ValType> boxedArgs;
+    // arguments of tail call, kept aside while the frame is overwritten
+    std::vector<int32_t> tailInts;
+    std::vector<BigFraction> tailFractions;
+    std::vector<ValType> tailStrings;
+
+    std::unique_ptr<JitCompiler> jit; // null when machine code is not generated
+};
+
+#endif //FRACTUS_REGISTERVM_H
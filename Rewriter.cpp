@@ -0,0 +1,21 @@
+//
+// Rewriter source file
+// Wiktor Franus, WUT 2017
+//
+
+#include "Rewriter.h"
+
+Rewriter::Rewriter(Arena &arena)
+: arena(arena)
+, replacement(nullptr)
+{}
+
+void Rewriter::rewrite(Node *const &link) {
+    replacement = nullptr;
+    link->accept(*this);
+    if (replacement) {
+        // visitors see nodes as const, but the tree being rewritten is owned by caller
+        const_cast<Node*&>(link) = replacement;
+        replacement = nullptr;
+    }
+}
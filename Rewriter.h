@@ -0,0 +1,27 @@
+//
+// Base of passes rewriting checked AST
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_REWRITER_H
+#define FRACTUS_REWRITER_H
+
+#include "Ast.h"
+
+/**
+ * Tree visitor which may replace visited nodes. A visit stores
+ * the new node in replacement and rewrite() links it in place of
+ * the old one. New nodes are placed in arena of the tree.
+ */
+class Rewriter : public Visitor {
+protected:
+    Rewriter(Arena &arena);
+
+    // visits node the link points to and replaces it if needed
+    void rewrite(Node *const &link);
+
+    Arena &arena;
+    Node *replacement;
+};
+
+#endif //FRACTUS_REWRITER_H
@@ -3,10 +3,75 @@
 // Wiktor Franus, WUT 2017
 //
 
+#include <algorithm>
 #include <climits>
+#include <cstdint>
 #include "Scanner.h"
 
-Scanner::Scanner(Reader *source) : isCharPreloaded(false), errorOccurred(false) {
+/**
+ * Keywords are recognized by their length and first letter, which are
+ * unique among them. Lookup table is built at compile time, so a word
+ * is classified with one table load and one comparison.
+ */
+
+struct Keyword {
+    std::string_view text;
+    Token token;
+};
+
+static constexpr Keyword keywords[] = {
+        {"program", PROGRAM},
+        {"var",     VAR},
+        {"begin",   BEGIN},
+        {"end",     END},
+        {"return",  RETURN},
+        {"if",      IF},
+        {"then",    THEN},
+        {"else",    ELSE},
+        {"do",      DO},
+        {"while",   WHILE},
+        {"or",      OROP},
+        {"and",     ANDOP},
+        {"void",    VOIDTYPE},
+        {"string",  STRINGTYPE},
+        {"integer", INTEGERTYPE},
+        {"fraction",FRACTIONTYPE},
+        {"boolean", BOOLEANTYPE},
+};
+
+static constexpr size_t MAX_KEYWORD_LENGTH = 8;
+
+struct KeywordTable {
+    // index + 1 of keyword with given length and first letter, 0 if none
+    uint8_t entry[MAX_KEYWORD_LENGTH + 1][26];
+    bool collision;
+};
+
+static constexpr KeywordTable makeKeywordTable() {
+    KeywordTable table{};
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i) {
+        uint8_t &entry = table.entry[keywords[i].text.size()][keywords[i].text[0] - 'a'];
+        table.collision = table.collision || entry != 0;
+        entry = static_cast<uint8_t>(i + 1);
+    }
+    return table;
+}
+
+static constexpr KeywordTable keywordTable = makeKeywordTable();
+static_assert(!keywordTable.collision, "keywords must differ in length or first letter");
+
+Token Scanner::keyword(std::string_view word) {
+    if (word.size() > MAX_KEYWORD_LENGTH || word[0] < 'a' || word[0] > 'z') {
+        return IDENTIFIER;
+    }
+    uint8_t entry = keywordTable.entry[word.size()][word[0] - 'a'];
+    if (entry && keywords[entry - 1].text == word) {
+        return keywords[entry - 1].token;
+    }
+    return IDENTIFIER;
+}
+
+Scanner::Scanner(Reader *source) : isCharPreloaded(false), errorOccurred(false), lastSymbol(0) {
     this->source = source;
 }
 
@@ -23,25 +88,30 @@ Token Scanner::nextSymbol() {
         // skip comment in current line
         if (c == '#') {
             do c = source->nextChar();
-            while (c != '\n');
+            while (c != '\n' && c != EOF);
         }
     } while (isspace(c) || c == '#');
+    if (c == EOF) {
+        return END_OF_FILE;
+    }
 
-    // keyword or identifier
+    // keyword or identifier, c is the last char taken from buffer
     if (isalpha(c)) {
-        lastString.clear();
-        do {
-            lastString.push_back(c);
-            c = source->nextChar();
-        } while (isalnum(c));
+        const char *begin = source->position() - 1;
+        const char *p = source->position();
+        while (p != source->end() && isalnum(*p)) {
+            ++p;
+        }
+        source->skipTo(p);
+        lastString = std::string_view(begin, p - begin);
+        c = source->nextChar();
         isCharPreloaded = true;
 
-        auto kwtoken = KeyWords.find(lastString);
-        if (kwtoken != KeyWords.end()) {
-            return (*kwtoken).second;
-        } else {
-            return IDENTIFIER;
+        Token t = keyword(lastString);
+        if (t == IDENTIFIER) {
+            lastSymbol = SymbolTable::intern(lastString);
         }
+        return t;
     }
 
     // integer or fraction
@@ -59,16 +129,15 @@ Token Scanner::nextSymbol() {
             if (c == '.') {
                 c = source->nextChar();
                 if (isdigit(c)) {
-                    Fraction f;
-                    f.whole = lastNumber;
-                    readInt(f.numerator);
+                    int numerator, denominator;
+                    readInt(numerator);
                     if (c == '_') {
                         c = source->nextChar();
-                        readInt(f.denominator);
-                        lastFraction = f;
-                        if (f.denominator == 0) {
+                        readInt(denominator);
+                        if (denominator == 0) {
                             ScanError("Denominator has to be different than 0!");
                         }
+                        lastFraction = Fraction(lastNumber, numerator, denominator);
                         return FRACTCONST;
                     } else {
                         ScanError("Invalid fraction constant: no symbol '_'");
@@ -79,12 +148,13 @@ Token Scanner::nextSymbol() {
                     return INTCONST;
                 }
             } else if (c == '_'){
-                Fraction f;
-                f.whole = 0;
-                f.numerator = lastNumber;
+                int denominator;
                 c = source->nextChar();
-                readInt(f.denominator);
-                lastFraction = f;
+                readInt(denominator);
+                if (denominator == 0) {
+                    ScanError("Denominator has to be different than 0!");
+                }
+                lastFraction = Fraction(0, lastNumber, denominator);
                 return FRACTCONST;
             } else {
                 return INTCONST;
@@ -95,7 +165,7 @@ Token Scanner::nextSymbol() {
         }
     }
     if (c == '"') {
-        lastString.clear();
+        lastString = std::string_view();
         c = source->nextChar();
         if (c == '"') {
             c = source->nextChar();
@@ -103,10 +173,17 @@ Token Scanner::nextSymbol() {
             return CHARCONST;
         }
 
-        do {
-            lastString.push_back(c);
-            c = source->nextChar();
-        } while (c != '"');
+        // text up to closing quote, taken directly from buffer
+        const char *begin = source->position();
+        if (c != EOF) {
+            --begin;
+        }
+        const char *close = std::find(begin, source->end(), '"');
+        if (close == source->end()) {
+            ScanError("Invalid char constant: no closing quote");
+        }
+        source->skipTo(close + 1);
+        lastString = std::string_view(begin, close - begin);
 
         c = source->nextChar();
         if (c == '"') {
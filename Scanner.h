@@ -6,10 +6,11 @@
 #ifndef FRACTUS_SCANNER_H
 #define FRACTUS_SCANNER_H
 
-#include <map>
 #include <iostream>
+#include <string_view>
 #include "Reader.h"
 #include "Fraction.h"
+#include "Symbol.h"
 
 enum Token {
     PROGRAM,
@@ -65,35 +66,24 @@ public:
 
 class Scanner {
 public:
-    std::map<std::string, Token> KeyWords = {
-            {"program", PROGRAM},
-            {"var",     VAR},
-            {"begin",   BEGIN},
-            {"end",     END},
-            {"return",  RETURN},
-            {"if",      IF},
-            {"then",    THEN},
-            {"else",    ELSE},
-            {"do",      DO},
-            {"while",   WHILE},
-            {"or",      OROP},
-            {"and",     ANDOP},
-            {"void",    VOIDTYPE},
-            {"string",  STRINGTYPE},
-            {"integer", INTEGERTYPE},
-            {"fraction",FRACTIONTYPE},
-            {"boolean", BOOLEANTYPE},
-    };
-
     Scanner(Reader*);
     ~Scanner() {};
 
     Token nextSymbol();
 
-    std::string getLastString() const {
+    // keyword token for given word, IDENTIFIER if it is not a keyword
+    static Token keyword(std::string_view word);
+
+    // identifier or string constant, valid as long as the Reader
+    std::string_view getLastString() const {
         return lastString;
     }
 
+    // interned name of last identifier
+    Symbol getLastSymbol() const {
+        return lastSymbol;
+    }
+
     int getLine() const {
         return source->getLine();
     }
@@ -127,7 +117,8 @@ private:
     bool errorOccurred;
     int lastNumber;
     Fraction lastFraction;
-    std::string lastString;
+    std::string_view lastString; // slice of Reader buffer
+    Symbol lastSymbol;
 };
 
 
@@ -4,28 +4,33 @@
 //
 
 #include "Scope.h"
+#include "Numeric.h"
 
 /**
  * Descriptor c-tors
  */
-Descriptor::Descriptor(const std::string &name, DescType type)
+Descriptor::Descriptor(Symbol name, DescType type)
 : name(name)
 , type(type)
 {}
 
-BuiltInTypeDescriptor::BuiltInTypeDescriptor(const std::string &name)
+BuiltInTypeDescriptor::BuiltInTypeDescriptor(Symbol name)
 : Descriptor(name, DescType::BuiltInType)
 {}
 
-VarDescriptor::VarDescriptor(const std::string &name, BuiltInTypeDescriptor *type)
+VarDescriptor::VarDescriptor(Symbol name, BuiltInTypeDescriptor *type)
         : Descriptor(name, DescType::Var)
         , typeDesc(type)
+        , slot(0)
 {}
 
-ProcDescriptor::ProcDescriptor(const std::string &name, const std::string &retType, std::vector<VarDescriptor*> &params)
+ProcDescriptor::ProcDescriptor(Symbol name, Symbol retType, std::vector<VarDescriptor*> &params)
         : Descriptor(name, DescType::Proc)
         , retType(retType)
         , params(params)
+        , declaration(nullptr)
+        , scope(nullptr)
+        , pure(false)
 {}
 
 
@@ -51,14 +56,14 @@ void ProcDescriptor::accept(DescVisitor &v) const {
  */
 
 std::ostream& operator<<(std::ostream& stream, const BuiltInTypeDescriptor &d) {
-    stream << "<BuildInTypeDescriptor(name=" << d.name << ")>";
+    stream << "<BuildInTypeDescriptor(name=" << SymbolTable::name(d.name) << ")>";
     return stream;
 }
 
 std::ostream& operator<<(std::ostream& stream, const VarDescriptor &d) {
-    stream << "<VarDescriptor(name='" << d.name << "', type='";
+    stream << "<VarDescriptor(name='" << SymbolTable::name(d.name) << "', type='";
     if (d.typeDesc) {
-        stream << d.typeDesc->name;
+        stream << SymbolTable::name(d.typeDesc->name);
     } else {
         stream << "UNKNOWN!";
     }
@@ -67,7 +72,7 @@ std::ostream& operator<<(std::ostream& stream, const VarDescriptor &d) {
 }
 
 std::ostream& operator<<(std::ostream& stream, const ProcDescriptor &d) {
-    stream << "<ProcDescriptor(name=" << d.name << ", parameters=[";
+    stream << "<ProcDescriptor(name=" << SymbolTable::name(d.name) << ", parameters=[";
 
     for (VarDescriptor* param : d.params) {
         stream << *param << ",";
@@ -105,15 +110,16 @@ void PrintDescVisitor::visit(const ProcDescriptor *n) {
  * Scope c-tor, d-tor
  */
 
-Scope::Scope(const std::string &name, unsigned int level, Scope *extscope)
+Scope::Scope(Symbol name, unsigned int level, Scope *extscope)
 : scopeName(name)
 , level(level)
 , enclosingScope(extscope)
+, slotCount(0)
 {}
 
 Scope::~Scope() {
     for (auto nameDescPair : symbols) {
-        if (nameDescPair.first == "print" || nameDescPair.first == "read") {
+        if (nameDescPair.first == SYM_PRINT || nameDescPair.first == SYM_READ) {
             // free manually allocated memory for these "builtin" methods
             ProcDescriptor *procDesc = static_cast<ProcDescriptor*>(nameDescPair.second);
             delete procDesc->params[0];
@@ -128,10 +134,14 @@ Scope::~Scope() {
 
 Descriptor* Scope::insert(Descriptor *symbol) {
     //std::cout << "Insert: " << symbol->name << std::endl;
-    return (*(symbols.insert({symbol->name, symbol}).first)).second;
+    auto inserted = symbols.insert({symbol->name, symbol});
+    if (inserted.second && symbol->type == DescType::Var) {
+        static_cast<VarDescriptor*>(symbol)->slot = slotCount++;
+    }
+    return (*inserted.first).second;
 }
 
-Descriptor* Scope::lookup(const std::string &name, bool currentScopeOnly) {
+Descriptor* Scope::lookup(Symbol name, bool currentScopeOnly) {
     //std::cout << "Lookup: " << name << ". (Scope name: " << scopeName << ")" << std::endl;
     auto it = symbols.find(name);
     if (it != symbols.end()) {
@@ -152,6 +162,18 @@ Descriptor* Scope::lookup(const std::string &name, bool currentScopeOnly) {
     return nullptr;
 }
 
+Descriptor* Scope::lookup(Symbol name, unsigned int &depth) {
+    // depth - number of scopes between this one and scope declaring the symbol
+    depth = 0;
+    for (Scope *scope = this; scope != nullptr; scope = scope->enclosingScope, ++depth) {
+        auto it = scope->symbols.find(name);
+        if (it != scope->symbols.end()) {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
 Scope *Scope::getEnclosingScope() const {
     return enclosingScope;
 }
@@ -160,7 +182,7 @@ unsigned int Scope::getLevel() const {
     return level;
 }
 
-const std::string &Scope::getScopeName() const {
+Symbol Scope::getScopeName() const {
     return scopeName;
 }
 
@@ -168,27 +190,44 @@ Scope::Symbols const &Scope::getSymbolTable() const {
     return symbols;
 }
 
+unsigned int Scope::getSlotCount() const {
+    return slotCount;
+}
+
+const std::vector<ValType> &Scope::getFrameLayout() {
+    if (frameLayout.size() != slotCount) {
+        frameLayout.assign(slotCount, ValType());
+        for (auto nameDescPair : symbols) {
+            if (nameDescPair.second->type == DescType::Var) {
+                VarDescriptor *varDesc = static_cast<VarDescriptor*>(nameDescPair.second);
+                frameLayout[varDesc->slot] = initialValue(varDesc);
+            }
+        }
+    }
+    return frameLayout;
+}
+
 void Scope::initializeBuiltInTypes() {
-    insert(new BuiltInTypeDescriptor("integer"));
-    //insert(new BuiltInTypeDescriptor("false"));
-    //insert(new BuiltInTypeDescriptor("true"));
-    BuiltInTypeDescriptor *boolDesc = new BuiltInTypeDescriptor("boolean");
-    BuiltInTypeDescriptor *fractionDesc = new BuiltInTypeDescriptor("fraction");
-    BuiltInTypeDescriptor *stringDesc = new BuiltInTypeDescriptor("string");
+    insert(new BuiltInTypeDescriptor(SYM_INTEGER));
+    //insert(new BuiltInTypeDescriptor(SYM_FALSE));
+    //insert(new BuiltInTypeDescriptor(SYM_TRUE));
+    BuiltInTypeDescriptor *boolDesc = new BuiltInTypeDescriptor(SYM_BOOLEAN);
+    BuiltInTypeDescriptor *fractionDesc = new BuiltInTypeDescriptor(SYM_FRACTION);
+    BuiltInTypeDescriptor *stringDesc = new BuiltInTypeDescriptor(SYM_STRING);
     insert(boolDesc);
     insert(stringDesc);
     insert(fractionDesc);
 
     std::vector<VarDescriptor*> printParams;
-    printParams.push_back(new VarDescriptor("s", stringDesc));
-    insert(new ProcDescriptor("print", "void", printParams));
+    printParams.push_back(new VarDescriptor(SymbolTable::intern("s"), stringDesc));
+    insert(new ProcDescriptor(SYM_PRINT, SYM_VOID, printParams));
 
     std::vector<VarDescriptor*> readParams;
-    readParams.push_back(new VarDescriptor("f", fractionDesc));
-    insert(new ProcDescriptor("read", "void", readParams));
+    readParams.push_back(new VarDescriptor(SymbolTable::intern("f"), fractionDesc));
+    insert(new ProcDescriptor(SYM_READ, SYM_VOID, readParams));
 
-    VarDescriptor *falseDesc = new VarDescriptor("false", boolDesc);
-    VarDescriptor *trueDesc = new VarDescriptor("true", boolDesc);
+    VarDescriptor *falseDesc = new VarDescriptor(SYM_FALSE, boolDesc);
+    VarDescriptor *trueDesc = new VarDescriptor(SYM_TRUE, boolDesc);
     insert(falseDesc);
     insert(trueDesc);
 }
@@ -196,10 +235,10 @@ void Scope::initializeBuiltInTypes() {
 std::ostream& operator<<(std::ostream& os, const Scope& obj) {
     os << std::endl << "SCOPE SYMBOL TABLE" << std::endl;
     os << "==================" << std::endl;
-    os << "Scope name : " << obj.scopeName << std::endl;
+    os << "Scope name : " << SymbolTable::name(obj.scopeName) << std::endl;
     os << "Scope level : " << obj.level << std::endl;
     if (obj.enclosingScope) {
-        os << "Enclosing scope : " << obj.enclosingScope->scopeName << std::endl;
+        os << "Enclosing scope : " << SymbolTable::name(obj.enclosingScope->scopeName) << std::endl;
     } else {
         os << "Enclosing scope : " << "None" << std::endl;
     }
@@ -219,147 +258,187 @@ std::ostream& operator<<(std::ostream& os, const Scope& obj) {
  * All things connected with Values
  */
 
-Value::Value()
-: boolVal(false)
-, intVal(0)
-, stringVal("")
-, fractVal(Fraction())
-{}
+static_assert(sizeof(ValType) == 16, "ValType is expected to be 16 bytes");
+
+ValType ValType::fromBool(bool b) {
+    ValType v;
+    v.tag = Type::Bool;
+    v.word = b;
+    return v;
+}
+
+ValType ValType::fromInt(int i) {
+    ValType v;
+    v.tag = Type::Int;
+    v.word = i;
+    return v;
+}
 
-Value::Value(const Value &oth) {
-    this->boolVal = oth.boolVal;
-    this->fractVal = oth.fractVal;
-    this->stringVal = std::string(oth.stringVal);
-    this->intVal = oth.intVal;
+ValType ValType::fromFraction(const Fraction &f) {
+    ValType v;
+    v.tag = Type::Fraction;
+    v.word = f.whole;
+    v.fract.numerator = f.numerator;
+    v.fract.denominator = f.denominator;
+    return v;
 }
 
-Value::Value(Value &&oth) {
-    //std::cout<< "MOVE" << std::endl;
-    this->boolVal = std::move(oth.boolVal);
-    this->fractVal = std::move(oth.fractVal);
-    this->stringVal = std::move(oth.stringVal);
-    this->intVal = std::move(oth.intVal);
+ValType ValType::fromFraction(const BigFraction &f) {
+    if (f.isSmall()) {
+        return fromFraction(f.smallValue());
+    }
+    ValType v;
+    v.tag = Type::Fraction;
+    v.heap = true;
+    v.bigFract = f.big;
+    ++v.bigFract->refCount;
+    return v;
+}
+
+ValType ValType::fromString(const std::string &s) {
+    ValType v;
+    v.tag = Type::String;
+    v.heap = true;
+    v.string = new StringObject(s);
+    return v;
+}
+
+void ValType::releaseHeap() {
+    if (tag == Type::String) {
+        if (--string->refCount == 0) {
+            delete string;
+        }
+    } else if (--bigFract->refCount == 0) {
+        delete bigFract;
+    }
 }
 
-Value &Value::operator=(const Value &oth) {
-    if (this != &oth) {
-        this->boolVal = oth.boolVal;
-        this->stringVal = oth.stringVal;
-        this->intVal = oth.intVal;
-        this->fractVal = Fraction(oth.fractVal);
+BigFraction ValType::fractVal() const {
+    BigFraction f;
+    if (heap) {
+        f.big = bigFract;
+        f.retain();
+        return f;
     }
-    return *this;
+    f.small = smallFractVal();
+    return f;
 }
 
 ValType operator+(const ValType &left, const ValType &right) {
-    Value ret;
-    Type opType = left.second;
-    switch (opType) {
+    switch (left.type()) {
         case Type::Int:
-            ret.intVal = left.first.intVal + right.first.intVal;
-            break;
+            return ValType::fromInt(left.intVal() + right.intVal());
         case Type::String:
-            ret.stringVal = left.first.stringVal + right.first.stringVal;
-            break;
-        case Type::Fraction:
-            ret.fractVal = left.first.fractVal + right.first.fractVal;
-            break;
+            return ValType::fromString(left.stringVal() + right.stringVal());
+        case Type::Fraction: {
+            Fraction result;
+            if (left.isSmallFraction() && right.isSmallFraction()
+                && checkedAdd(left.smallFractVal(), right.smallFractVal(), result)) {
+                return ValType::fromFraction(result);
+            }
+            return ValType::fromFraction(left.fractVal() + right.fractVal());
+        }
         default:
-            break;
+            return left;
     }
-    return std::make_pair(ret, opType);
 }
 
 ValType operator-(const ValType &left, const ValType &right) {
-    Value ret;
-    Type opType = left.second;
-    switch (opType) {
+    switch (left.type()) {
         case Type::Int:
-            ret.intVal = left.first.intVal - right.first.intVal;
-            break;
-        case Type::Fraction:
-            ret.fractVal = left.first.fractVal - right.first.fractVal;
-            break;
+            return ValType::fromInt(left.intVal() - right.intVal());
+        case Type::Fraction: {
+            Fraction result;
+            if (left.isSmallFraction() && right.isSmallFraction()
+                && checkedSubtract(left.smallFractVal(), right.smallFractVal(), result)) {
+                return ValType::fromFraction(result);
+            }
+            return ValType::fromFraction(left.fractVal() - right.fractVal());
+        }
         default:
-            break;
+            return left;
     }
-    return std::make_pair(ret, opType);
 }
 
 ValType operator*(const ValType &left, const ValType &right) {
-    Value ret;
-    Type opType = left.second;
-    switch (opType) {
+    switch (left.type()) {
         case Type::Int:
-            ret.intVal = left.first.intVal * right.first.intVal;
-            break;
-        case Type::Fraction:
-            ret.fractVal = left.first.fractVal * right.first.fractVal;
-            break;
+            return ValType::fromInt(left.intVal() * right.intVal());
+        case Type::Fraction: {
+            Fraction result;
+            if (left.isSmallFraction() && right.isSmallFraction()
+                && checkedMultiply(left.smallFractVal(), right.smallFractVal(), result)) {
+                return ValType::fromFraction(result);
+            }
+            return ValType::fromFraction(left.fractVal() * right.fractVal());
+        }
         default:
-            break;
+            return left;
     }
-    return std::make_pair(ret, opType);
 }
 
 ValType operator/(const ValType &left, const ValType &right) {
-    Value ret;
-    Type opType = left.second;
-    switch (opType) {
+    switch (left.type()) {
         case Type::Int:
-            ret.intVal = left.first.intVal / right.first.intVal;
-            break;
+            return ValType::fromInt(wrappingDivide(left.intVal(), right.intVal()));
         case Type::Fraction:
-            ret.fractVal = left.first.fractVal / right.first.fractVal;
-            break;
+            return ValType::fromFraction(left.fractVal() / right.fractVal());
         default:
-            break;
+            return left;
     }
-    return std::make_pair(ret, opType);
 }
 
 bool operator==(const ValType &left, const ValType &right) {
-    if (left.second == Type::Void || right.second == Type::Void) {
+    if (left.type() == Type::Void || right.type() == Type::Void) {
         return false;
     }
-    switch (left.second) {
+    switch (left.type()) {
         case Type::Bool:
-            return left.first.boolVal == right.first.boolVal;
+            return left.boolVal() == right.boolVal();
         case Type::Int:
-            return left.first.intVal == right.first.intVal;
+            return left.intVal() == right.intVal();
         case Type ::String:
-            return left.first.stringVal == right.first.stringVal;
+            return left.stringVal() == right.stringVal();
         case Type::Fraction:
-            return left.first.fractVal == right.first.fractVal;
+            if (left.isSmallFraction() && right.isSmallFraction()) {
+                return left.smallFractVal() == right.smallFractVal();
+            }
+            return left.fractVal() == right.fractVal();
         default:
             return false;
     }
 }
 
 bool operator!=(const ValType &left, const ValType &right) {
-    if (left.second == Type::Void || right.second == Type::Void) {
+    if (left.type() == Type::Void || right.type() == Type::Void) {
         return false;
     }
     return !(left == right);
 }
 
 bool operator<(const ValType &left, const ValType &right) {
-    switch (left.second) {
+    switch (left.type()) {
         case Type::Int:
-            return left.first.intVal < right.first.intVal;
+            return left.intVal() < right.intVal();
         case Type::Fraction:
-            return left.first.fractVal < right.first.fractVal;
+            if (left.isSmallFraction() && right.isSmallFraction()) {
+                return left.smallFractVal() < right.smallFractVal();
+            }
+            return left.fractVal() < right.fractVal();
         default:
             return false;
     }
 }
 
 bool operator>(const ValType &left, const ValType &right) {
-    switch (left.second) {
+    switch (left.type()) {
         case Type::Int:
-            return left.first.intVal > right.first.intVal;
+            return left.intVal() > right.intVal();
         case Type::Fraction:
-            return left.first.fractVal > right.first.fractVal;
+            if (left.isSmallFraction() && right.isSmallFraction()) {
+                return left.smallFractVal() > right.smallFractVal();
+            }
+            return left.fractVal() > right.fractVal();
         default:
             return false;
     }
@@ -373,21 +452,35 @@ bool operator>=(const ValType &left, const ValType &right) {
     return !(left < right);
 }
 
+size_t hashValue(const ValType &value) {
+    switch (value.type()) {
+        case Type::Bool:
+        case Type::Int:
+            return std::hash<int>()(value.intVal());
+        case Type::String:
+            return std::hash<std::string>()(value.stringVal());
+        case Type::Fraction:
+            return value.fractVal().hash();
+        default:
+            return 0;
+    }
+}
+
 std::ostream& operator<<(std::ostream &os, const ValType &obj) {
-    switch (obj.second) {
+    switch (obj.type()) {
         case Type::Bool: {
-            std::string s = obj.first.boolVal ? "true" : "false";
+            std::string s = obj.boolVal() ? "true" : "false";
             os << s;
             break;
         }
         case Type::Int:
-            os << obj.first.intVal;
+            os << obj.intVal();
             break;
         case Type::String:
-            os << obj.first.stringVal;
+            os << obj.stringVal();
             break;
         case Type::Fraction:
-            os << obj.first.fractVal;
+            os << obj.fractVal();
             break;
         default:
             break;
@@ -396,19 +489,31 @@ std::ostream& operator<<(std::ostream &os, const ValType &obj) {
 }
 
 std::istream& operator>>(std::istream &is, ValType &obj) {
-    switch (obj.second) {
-        case Type::Bool:
-            is >> obj.first.boolVal;
+    switch (obj.type()) {
+        case Type::Bool: {
+            bool b = obj.boolVal();
+            is >> b;
+            obj = ValType::fromBool(b);
             break;
-        case Type::Int:
-            is >> obj.first.intVal;
+        }
+        case Type::Int: {
+            int i = obj.intVal();
+            is >> i;
+            obj = ValType::fromInt(i);
             break;
-        case Type::String:
-            is >> obj.first.stringVal;
+        }
+        case Type::String: {
+            std::string s = obj.stringVal();
+            is >> s;
+            obj = ValType::fromString(s);
             break;
-        case Type::Fraction:
-            is >> obj.first.fractVal;
+        }
+        case Type::Fraction: {
+            BigFraction f = obj.fractVal();
+            is >> f;
+            obj = ValType::fromFraction(f);
             break;
+        }
         default:
             break;
     }
@@ -416,67 +521,26 @@ std::istream& operator>>(std::istream &is, ValType &obj) {
 }
 
 /**
- * Context c-tors
+ * Context c-tor
  */
 
-Context::Context(Scope *ctxScope, Context *globalCtx)
+Context::Context(Scope *ctxScope, ValType *slots, Context *globalCtx)
 : contextScope(ctxScope)
 , globalContext(globalCtx)
-, returnValue({Value(), Type::Void}) {
-    initializeVariables();
-}
-
-Context::Context(Context &&oth) {
-    this->contextScope = oth.contextScope;
-    this->globalContext = oth.globalContext;
-    this->environment = oth.environment;
-    this->returnValue = oth.returnValue;
-
-    oth.contextScope = nullptr;
-    oth.globalContext = nullptr;
-}
-
-Descriptor *Context::getVariableDescriptor(const std::string &name) {
-    return contextScope->lookup(name);
-}
-
-ValType &Context::getVariableValue(const std::string &varName){
-    auto it = environment.find(varName);
-    if (it != environment.end()) {
-        return (*it).second;
-    }
+, slots(slots)
+, returnValue()
+{}
 
-    if (globalContext) {
-        return globalContext->getVariableValue(varName);
+ValType &Context::getVariableValue(unsigned int depth, unsigned int slot) {
+    // variables of enclosing scope can only be the global ones
+    if (depth > 0 && globalContext) {
+        return globalContext->slots[slot];
     }
-
-    throw std::runtime_error("Variable not found in current context: " + varName);
-//    try {
-//        ValType &val = environment.at(varName);
-//        return val;
-//    } catch (std::out_of_range e) {
-//        throw std::runtime_error("Variable not found in current context: " + varName);
-//    }
+    return slots[slot];
 }
 
-void Context::setVariableValue(const std::string &varName, const Value &value){
-    auto it = environment.find(varName);
-    if (it != environment.end()) {
-        environment[varName].first = value;
-        return;
-    }
-
-    if (globalContext) {
-        return globalContext->setVariableValue(varName, value);
-    }
-
-    throw std::runtime_error("Variable not found in current context: " + varName);
-//    try {
-//        ValType &val = environment.at(varName);
-//        val.first = value;
-//    } catch (std::out_of_range e) {
-//        throw std::runtime_error("Variable not found in current context: " + varName);
-//    }
+void Context::setVariableValue(unsigned int depth, unsigned int slot, const ValType &value) {
+    getVariableValue(depth, slot) = value;
 }
 
 ValType Context::getReturnValue() {
@@ -487,43 +551,48 @@ void Context::setReturnValue(const ValType &val) {
     returnValue = val;
 }
 
-void Context::initializeVariables() {
-    if (contextScope != nullptr) {
-        for (auto nameDescPair : contextScope->getSymbolTable()) {
-            DescType descType = nameDescPair.second->type;
-            //if (descType == DescType::BuiltInType) {}
-            if ( descType == DescType::Var) {
-                VarDescriptor *varDesc = static_cast<VarDescriptor*>(nameDescPair.second);
-                ValType val;
-                if(varDesc->typeDesc->name == "boolean") {
-                    //std::cout << "bool" << std::endl;
-                    if (varDesc->name == "true") { // builtin variable called "true"
-                        val.first.boolVal = true;
-                    } else {
-                        val.first.boolVal = false;
-                    }
-                    val.second = Type::Bool;
-                }
-                if(varDesc->typeDesc->name == "integer") {
-                    //std::cout << "integer" << std::endl;
-
-                    val.first.intVal = 0;
-                    val.second = Type::Int;
-                }
-                if(varDesc->typeDesc->name == "string") {
-                    //std::cout << "string" << std::endl;
-
-                    val.first.stringVal = std::string();
-                    val.second = Type::String;
-                }
-                if(varDesc->typeDesc->name == "fraction") {
-                    //std::cout << "fraction" << std::endl;
-
-                    val.first.fractVal = Fraction();
-                    val.second = Type::Fraction;
-                }
-                environment.insert(std::make_pair(varDesc->name, val));
-            }
-        }
+ValType initialValue(const VarDescriptor *varDesc) {
+    switch (valueType(varDesc->typeDesc->name)) {
+        case Type::Bool:
+            // builtin variable called "true"
+            return ValType::fromBool(varDesc->name == SYM_TRUE);
+        case Type::Int:
+            return ValType::fromInt(0);
+        case Type::String:
+            return ValType::fromString(std::string());
+        case Type::Fraction:
+            return ValType::fromFraction(Fraction());
+        default:
+            return ValType();
+    }
+}
+
+Type valueType(Symbol typeName) {
+    switch (typeName) {
+        case SYM_BOOLEAN:
+            return Type::Bool;
+        case SYM_INTEGER:
+            return Type::Int;
+        case SYM_STRING:
+            return Type::String;
+        case SYM_FRACTION:
+            return Type::Fraction;
+        default:
+            return Type::Void;
+    }
+}
+
+Symbol typeName(Type type) {
+    switch (type) {
+        case Type::Bool:
+            return SYM_BOOLEAN;
+        case Type::Int:
+            return SYM_INTEGER;
+        case Type::String:
+            return SYM_STRING;
+        case Type::Fraction:
+            return SYM_FRACTION;
+        default:
+            return SYM_VOID;
     }
 }
@@ -8,15 +8,19 @@
 
 #include <iostream>
 
+#include <cstdint>
 #include <set>
 #include <vector>
 #include <unordered_map>
 #include <map>
 #include <functional>
 
-#include "Fraction.h"
+#include "BigFraction.h"
+#include "Symbol.h"
 
 class DescVisitor;
+class Scope;
+struct ProcDeclNode;
 
 
 /**
@@ -30,35 +34,41 @@ enum class DescType {
 };
 
 struct Descriptor {
-    Descriptor(const std::string &name, DescType type = DescType::Var);
+    Descriptor(Symbol name, DescType type = DescType::Var);
     virtual ~Descriptor() {}
     virtual void accept(DescVisitor &v) const = 0;
 
-    std::string name;
+    Symbol name;
     DescType type;
 };
 
 struct BuiltInTypeDescriptor : public Descriptor {
-    BuiltInTypeDescriptor(const std::string &name);
+    BuiltInTypeDescriptor(Symbol name);
     ~BuiltInTypeDescriptor() {}
     void accept(DescVisitor &v) const;
 };
 
 struct VarDescriptor : public Descriptor {
-    VarDescriptor(const std::string &name, BuiltInTypeDescriptor* typeDesc);
+    VarDescriptor(Symbol name, BuiltInTypeDescriptor* typeDesc);
     ~VarDescriptor() {}
     void accept(DescVisitor &v) const;
 
     BuiltInTypeDescriptor *typeDesc;
+    unsigned int slot; // index in frame of owning scope, assigned on insertion
 };
 
 struct ProcDescriptor : public Descriptor {
-    ProcDescriptor(const std::string &name, const std::string &retType, std::vector<VarDescriptor*> &params);
+    ProcDescriptor(Symbol name, Symbol retType, std::vector<VarDescriptor*> &params);
     ~ProcDescriptor() {}
     void accept(DescVisitor &v) const;
 
-    std::string retType;
+    Symbol retType;
     std::vector<VarDescriptor*> params;
+    // set by SemanticAnalyzer, both null for builtin procedures
+    const ProcDeclNode *declaration;
+    Scope *scope;
+    // result depends only on arguments: no global variables, input, output or impure callees
+    bool pure;
 };
 
 std::ostream& operator<<(std::ostream &os, const BuiltInTypeDescriptor &obj);
@@ -91,97 +101,225 @@ private:
 };
 
 
+enum class Type : uint8_t {
+    Void,
+    Bool,
+    Int,
+    String,
+    Fraction
+};
+
+/**
+ * String kept out of line, shared by values holding it
+ */
+struct StringObject {
+    StringObject(const std::string &s) : refCount(1), chars(s) {}
+
+    unsigned int refCount;
+    std::string chars;
+};
+
+/**
+ * Value in FraCtuS tagged with its type (16 bytes).
+ * Numbers are stored inline, strings and fractions too big
+ * for inline parts are reference counted.
+ */
+class ValType {
+public:
+    ValType() : tag(Type::Void), heap(false), word(0), string(nullptr) {}
+    ValType(const ValType &oth) : tag(oth.tag), heap(oth.heap), word(oth.word), string(oth.string) {
+        retain();
+    }
+    ValType(ValType &&oth) : tag(oth.tag), heap(oth.heap), word(oth.word), string(oth.string) {
+        oth.tag = Type::Void;
+        oth.heap = false;
+    }
+    ~ValType() {
+        release();
+    }
+    ValType &operator=(const ValType &oth) {
+        oth.retain();
+        release();
+        tag = oth.tag;
+        heap = oth.heap;
+        word = oth.word;
+        string = oth.string;
+        return *this;
+    }
+    ValType &operator=(ValType &&oth) {
+        if (this != &oth) {
+            release();
+            tag = oth.tag;
+            heap = oth.heap;
+            word = oth.word;
+            string = oth.string;
+            oth.tag = Type::Void;
+            oth.heap = false;
+        }
+        return *this;
+    }
+
+    static ValType fromBool(bool b);
+    static ValType fromInt(int i);
+    static ValType fromFraction(const Fraction &f);
+    static ValType fromFraction(const BigFraction &f);
+    static ValType fromString(const std::string &s);
+
+    Type type() const {
+        return tag;
+    }
+    bool boolVal() const {
+        return word != 0;
+    }
+    int intVal() const {
+        return word;
+    }
+    BigFraction fractVal() const;
+    // fractions fitting in inline parts take the fast paths
+    bool isSmallFraction() const {
+        return tag == Type::Fraction && !heap;
+    }
+    Fraction smallFractVal() const {
+        Fraction f;
+        f.whole = word;
+        f.numerator = fract.numerator;
+        f.denominator = fract.denominator;
+        return f;
+    }
+    const std::string &stringVal() const {
+        return string->chars;
+    }
+
+    // in-place updates, used by evaluation fast paths
+    void setBool(bool b) {
+        release();
+        tag = Type::Bool;
+        heap = false;
+        word = b;
+    }
+    void setInt(int i) {
+        release();
+        tag = Type::Int;
+        heap = false;
+        word = i;
+    }
+
+private:
+    struct FractionParts {
+        int32_t numerator;
+        int32_t denominator;
+    };
+
+    void retain() const {
+        if (heap) {
+            if (tag == Type::String) {
+                ++string->refCount;
+            } else {
+                ++bigFract->refCount;
+            }
+        }
+    }
+    void release() {
+        if (heap) {
+            releaseHeap();
+        }
+    }
+    void releaseHeap();
+
+    Type tag;
+    bool heap; // string or big fraction, reference counted
+    int32_t word; // bool, integer or whole part of fraction
+    union {
+        FractionParts fract;
+        StringObject *string;
+        BigFraction::BigValue *bigFract;
+    };
+};
+
+ValType operator+(const ValType &left, const ValType &right);
+ValType operator-(const ValType &left, const ValType &right);
+ValType operator*(const ValType &left, const ValType &right);
+ValType operator/(const ValType &left, const ValType &right);
+bool operator==(const ValType &left, const ValType &right);
+bool operator!=(const ValType &left, const ValType &right);
+bool operator<(const ValType &left, const ValType &right);
+bool operator>(const ValType &left, const ValType &right);
+bool operator<=(const ValType &left, const ValType &right);
+bool operator>=(const ValType &left, const ValType &right);
+std::ostream& operator<<(std::ostream &os, const ValType &obj);
+std::istream& operator>>(std::istream &is, ValType &obj);
+
+// equal values of one type have equal hashes, keys values in hash tables
+size_t hashValue(const ValType &value);
+
+// initial (default) value of declared variable
+ValType initialValue(const VarDescriptor *varDesc);
+
+// type of values of builtin type with given name and name of value type
+Type valueType(Symbol typeName);
+Symbol typeName(Type type);
+
+
 /**
  * Class representing procedure (or global) scope
  */
 class Scope {
-    using Symbols = std::unordered_map<std::string, Descriptor*>;
+    using Symbols = std::unordered_map<Symbol, Descriptor*>;
 public:
-    Scope(const std::string& name, unsigned int level, Scope *extscope);
+    Scope(Symbol name, unsigned int level, Scope *extscope);
     ~Scope();
 
     // scope interface methods
     Descriptor *insert(Descriptor *symbol);
-    Descriptor *lookup(const std::string &name, bool currentScopeOnly = false);
+    Descriptor *lookup(Symbol name, bool currentScopeOnly = false);
+    Descriptor *lookup(Symbol name, unsigned int &depth);
     void initializeBuiltInTypes();
 
     // getters, setters
-    const std::string &getScopeName() const;
+    Symbol getScopeName() const;
     unsigned int getLevel() const;
     Scope *getEnclosingScope() const;
     Symbols const &getSymbolTable() const;
+    unsigned int getSlotCount() const;
+    const std::vector<ValType> &getFrameLayout();
 
     friend std::ostream& operator<<(std::ostream& os, const Scope& obj);
 
 private:
-    std::string scopeName;
+    Symbol scopeName;
     unsigned int level;
     Scope *enclosingScope;
     Symbols symbols;
+    unsigned int slotCount;
+    std::vector<ValType> frameLayout; // initial values of variable slots, built on first use
 };
 
-/**
- * Struct representing value in FraCtuS.
- * Used together with value type in ValType pair.
- */
-struct Value {
-    Value();
-    Value(const Value &oth);
-    Value(Value &&oth);
-    Value &operator=(const Value &oth);
-
-    bool boolVal;
-    int intVal;
-    std::string stringVal;
-    Fraction fractVal;
-};
-
-enum class Type {
-    Void,
-    Bool,
-    Int,
-    String,
-    Fraction
-};
-
-using ValType = std::pair<Value, Type>;
-
-ValType operator+(const ValType &left, const ValType &right);
-ValType operator-(const ValType &left, const ValType &right);
-ValType operator*(const ValType &left, const ValType &right);
-ValType operator/(const ValType &left, const ValType &right);
-bool operator==(const ValType &left, const ValType &right);
-bool operator!=(const ValType &left, const ValType &right);
-bool operator<(const ValType &left, const ValType &right);
-bool operator>(const ValType &left, const ValType &right);
-bool operator<=(const ValType &left, const ValType &right);
-bool operator>=(const ValType &left, const ValType &right);
-std::ostream& operator<<(std::ostream &os, const ValType &obj);
-std::istream& operator>>(std::istream &is, ValType &obj);
-
 
 /**
- * Representation of running context (running frame/stack frame)
+ * Representation of running context (running frame/stack frame).
+ * Variables of the frame are stored in interpreter's value stack.
  */
 class Context {
-    using Environment = std::map<std::string, ValType>;
-
 public:
-    Context(Scope *contextScope, Context *globalContext);
-    Context(Context &&oth);
+    Context(Scope *contextScope, ValType *slots, Context *globalContext);
 
-    Descriptor *getVariableDescriptor(const std::string &name);
-    ValType &getVariableValue(const std::string &varName);
-    void setVariableValue(const std::string &varName, const Value &value);
+    ValType &getVariableValue(unsigned int depth, unsigned int slot);
+    void setVariableValue(unsigned int depth, unsigned int slot, const ValType &value);
     ValType getReturnValue();
     void setReturnValue(const ValType &val);
+    ValType *getSlots() const {
+        return slots;
+    }
+    // after stacks holding frames and their slots have moved
+    void relocate(ValType *newSlots, Context *newGlobalContext) {
+        slots = newSlots;
+        globalContext = newGlobalContext;
+    }
 
 private:
-    void initializeVariables();
-
     Scope *contextScope;
     Context *globalContext;
-    Environment environment;
+    ValType *slots;
     ValType returnValue;
 };
 
@@ -7,12 +7,15 @@
 
 SemanticAnalyzer::SemanticAnalyzer()
 : currentScope(nullptr)
-, prototypes(new std::map<std::string, Scope*>)
+, prototypes(new Prototypes)
+, returnType(Type::Void)
+, currentProc(nullptr)
+, truthWritten(false)
 {}
 
 SemanticAnalyzer::~SemanticAnalyzer() {
-    for (auto nameScopePair : *prototypes) {
-        delete nameScopePair.second;
+    for (Scope *scope : *prototypes) {
+        delete scope;
     }
     delete prototypes;
 }
@@ -32,13 +35,14 @@ void SemanticAnalyzer::visit(const BlockNode *n) {
 
 void SemanticAnalyzer::visit(const ProgramNode *n) {
     //std::cout << "ENTER scope: global" << std::endl;
-    Scope* global_scope = new Scope("global", 1, currentScope);
+    Scope* global_scope = new Scope(SYM_GLOBAL, 1, currentScope);
     global_scope->initializeBuiltInTypes();
-    prototypes->insert(std::make_pair(global_scope->getScopeName(), global_scope));
+    prototypes->push_back(global_scope);
 
     currentScope = global_scope;
 
     visit(n->block);
+    classifyProcedures();
 
     std::cout << *global_scope << std::endl;
 
@@ -54,35 +58,103 @@ void SemanticAnalyzer::visit(const CompoundNode *n) {
 }
 
 void SemanticAnalyzer::visit(const AssignNode *n) {
-    // type checking here
     n->left->accept(*this);
     n->right->accept(*this);
+    if (n->right->type == Type::Void) {
+        throw ParseException("Semantic error: Cannot assign expression of type void");
+    }
+    // variable holds value of its declared type
+    if (n->right->type != n->left->type) {
+        throw ParseException("Semantic error: Cannot assign expression of type " + typeText(n->right->type)
+                             + " to variable '" + SymbolTable::name(n->left->name) + "' of type "
+                             + typeText(n->left->type));
+    }
+    n->type = n->left->type;
+    if (isTruthConstant(n->left)) {
+        truthWritten = true;
+    }
 }
 
 void SemanticAnalyzer::visit(const BinOpNode *n) {
-//    visit(n->left);
-//    visit(n->right);
     n->left->accept(*this);
     n->right->accept(*this);
+    Type left = n->left->type, right = n->right->type;
+    if (left != right) {
+        throw ParseException("Semantic error: Incompatible types of operands: " + typeText(left)
+                             + " and " + typeText(right));
+    }
+    switch (n->op) {
+        case PLUS:
+            // int, fraction or string operands are accepted
+            if (!isNumber(left) && left != Type::String) {
+                throw ParseException("Semantic error: Operands must be two numbers, fractions or strings");
+            }
+            n->type = left;
+            break;
+        case MINUS:
+        case MULTSIGN:
+        case DIVSIGN:
+            if (!isNumber(left)) {
+                throw ParseException("Semantic error: Operands must be numbers");
+            }
+            n->type = left;
+            break;
+        case EQOP:
+        case NEQOP:
+            if (left == Type::Void) {
+                throw ParseException("Semantic error: Cannot compare expressions of type void");
+            }
+            n->type = Type::Bool;
+            break;
+        default:
+            // relational operators
+            if (!isNumber(left)) {
+                throw ParseException("Semantic error: Operands must be numbers");
+            }
+            n->type = Type::Bool;
+            break;
+    }
 }
 
 void SemanticAnalyzer::visit(const LogicalOp *n) {
     n->left->accept(*this);
     n->right->accept(*this);
+    expectBoolean(n->left, "Operands of logical operator");
+    expectBoolean(n->right, "Operands of logical operator");
+    n->type = Type::Bool;
+}
+
+void SemanticAnalyzer::visit(const UnaryOpNode *n) {
+    n->expression->accept(*this);
+    if (n->op == NOTSIGN) {
+        expectBoolean(n->expression, "Operand of '!'");
+    } else if (!isNumber(n->expression->type)) {
+        throw ParseException("Semantic error: Operand must be a number");
+    }
+    n->type = n->expression->type;
 }
 
 void SemanticAnalyzer::visit(const ProcDeclNode *n) {
-    std::string procName = n->name;
-    std::string retType = n->returnType->typeName;
+    Symbol procName = n->name;
+    Symbol retType = n->returnType->typeName;
     std::vector<VarDescriptor*> params;
     ProcDescriptor* procDesc = new ProcDescriptor(procName, retType, params);
     currentScope->insert(procDesc);
 
     //std::cout << "ENTER scope: " << procName << std::endl;
     Scope* procScope = new Scope(procName, currentScope->getLevel() + 1, currentScope);
-    prototypes->insert(std::make_pair(procName, procScope));
+    prototypes->push_back(procScope);
+    procDesc->declaration = n;
+    n->descriptor = procDesc;
+    procDesc->scope = procScope;
+    procDesc->pure = true;
+    callees[procDesc];
 
     currentScope = procScope;
+    ProcDescriptor *enclosingProc = currentProc;
+    currentProc = procDesc;
+    Type enclosingReturnType = returnType;
+    returnType = valueType(retType);
 
     for (ParamNode* param : n->params) {
         Descriptor* descriptor = currentScope->lookup(param->typeNode->typeName);
@@ -98,11 +170,14 @@ void SemanticAnalyzer::visit(const ProcDeclNode *n) {
     std::cout << *procScope << std::endl;
 
     currentScope = currentScope->getEnclosingScope();
+    returnType = enclosingReturnType;
+    currentProc = enclosingProc;
     //std::cout << "LEAVE scope: " << procName << std::endl;
 }
 
 void SemanticAnalyzer::visit(const IfNode *n) {
     n->condition->accept(*this);
+    expectBoolean(n->condition, "Condition of if statement");
     n->thenNode->accept(*this);
     if (n->elseNode){
         n->elseNode->accept(*this);
@@ -111,30 +186,66 @@ void SemanticAnalyzer::visit(const IfNode *n) {
 
 void SemanticAnalyzer::visit(const WhileNode *n) {
     n->condition->accept(*this);
+    expectBoolean(n->condition, "Condition of while statement");
     n->statement->accept(*this);
 }
 
 void SemanticAnalyzer::visit(const ReturnNode *n) {
     n->expr->accept(*this);
+    // return from main program ends it with any value
+    if (currentScope->getScopeName() != SYM_GLOBAL && n->expr->type != returnType) {
+        throw ParseException("Semantic error: Incorrect procedure return type. Expected: " + typeText(returnType)
+                             + ", got: " + typeText(n->expr->type));
+    }
+    n->type = n->expr->type;
+
+    // procedure returning result of user procedure call can leave its frame to the callee
+    ProcCallNode *call = dynamic_cast<ProcCallNode*>(n->expr);
+    if (currentScope->getScopeName() != SYM_GLOBAL && call && !call->builtin) {
+        n->tailCall = call;
+    }
 }
 
 void SemanticAnalyzer::visit(const VarNode *n) {
-    if (currentScope->lookup(n->name) == nullptr) {
-        throw ParseException("Semantic error: Symbol(identifier) not found '" + n->name + "'");
+    unsigned int depth;
+    Descriptor *descriptor = currentScope->lookup(n->name, depth);
+    const std::string &name = SymbolTable::name(n->name);
+    if (descriptor == nullptr) {
+        throw ParseException("Semantic error: Symbol(identifier) not found '" + name + "'");
+    }
+    if (descriptor->type != DescType::Var) {
+        throw ParseException("Semantic error: Symbol '" + name + "' is not a variable");
+    }
+    // at runtime only current and global frames are reachable
+    if (depth > 0 && depth != currentScope->getLevel() - 1) {
+        throw ParseException("Semantic error: Variable '" + name + "' of enclosing procedure is not accessible");
+    }
+
+    n->depth = depth;
+    n->slot = static_cast<VarDescriptor*>(descriptor)->slot;
+    n->type = valueType(static_cast<VarDescriptor*>(descriptor)->typeDesc->name);
+
+    // global variables can be changed between calls
+    if (currentProc && depth > 0) {
+        if (isTruthConstant(n)) {
+            truthReaders.push_back(currentProc);
+        } else {
+            currentProc->pure = false;
+        }
     }
 }
 
 void SemanticAnalyzer::visit(const VarDeclNode *n) {
-    std::string typeName = n->typeNode->typeName;
+    Symbol typeName = n->typeNode->typeName;
     Descriptor* descriptor = currentScope->lookup(typeName);
     BuiltInTypeDescriptor* typeDescriptor = static_cast<BuiltInTypeDescriptor*>(descriptor);
 
-    std::string varName = n->varNode->name;
+    Symbol varName = n->varNode->name;
     VarDescriptor* varDescriptor = new VarDescriptor(varName, typeDescriptor);
 
     if (currentScope->lookup(varName, true) != nullptr) {
         delete varDescriptor;
-        throw ParseException("Semantic error: Duplicate identifier " + varName + " found");
+        throw ParseException("Semantic error: Duplicate identifier " + SymbolTable::name(varName) + " found");
     }
 
     currentScope->insert(varDescriptor);
@@ -150,22 +261,107 @@ void SemanticAnalyzer::visit(const ParamNode *n) {
 
 void SemanticAnalyzer::visit(const ProcCallNode *n) {
     Descriptor* descriptor = currentScope->lookup(n->proc->name);
-    ProcDescriptor *procDescriptor = static_cast<ProcDescriptor*>(descriptor);
-
-    if ( procDescriptor == nullptr) {
-        throw ParseException("Semantic error: Symbol(identifier) not found '" + n->proc->name + "'");
+    if (descriptor == nullptr) {
+        throw ParseException("Semantic error: Symbol(identifier) not found '" + SymbolTable::name(n->proc->name) + "'");
     }
+    if (descriptor->type != DescType::Proc) {
+        throw ParseException("Semantic error: Symbol '" + SymbolTable::name(n->proc->name) + "' is not a procedure");
+    }
+    ProcDescriptor *procDescriptor = static_cast<ProcDescriptor*>(descriptor);
     int procArgsNum = procDescriptor->params.size();
     int procCallArgsNum = n->arguments.size();
     if (procArgsNum != procCallArgsNum) {
         std::string errMsg;
         errMsg += "Semantic error: Wrong number of arguments for procedure: '";
-        errMsg += n->proc->name + "', expected: ";
+        errMsg += SymbolTable::name(n->proc->name) + "', expected: ";
         errMsg += std::to_string(procArgsNum) + ", but got: " + std::to_string(procCallArgsNum);
         throw ParseException(errMsg);
     }
+
+    for (Node *arg : n->arguments) {
+        arg->accept(*this);
+    }
+
+    // bind call to its callee once, no lookups are done at runtime
+    n->descriptor = procDescriptor;
+    n->type = valueType(procDescriptor->retType);
+    if (procDescriptor->name == SYM_PRINT && !procDescriptor->declaration) {
+        // prints value of any type
+        n->builtin = builtinPrint;
+        if (currentProc) {
+            currentProc->pure = false;
+        }
+        return;
+    } else if (procDescriptor->name == SYM_READ && !procDescriptor->declaration) {
+        const VarNode *varNode = dynamic_cast<const VarNode*>(n->arguments[0]);
+        if (!varNode) {
+            throw ParseException("Semantic error: Argument of read must be a variable");
+        }
+        n->builtin = builtinRead;
+        if (currentProc) {
+            currentProc->pure = false;
+        }
+        if (isTruthConstant(varNode)) {
+            truthWritten = true;
+        }
+        return;
+    }
+    if (currentProc) {
+        callees[currentProc].push_back(procDescriptor);
+    }
+
+    for (size_t i = 0; i < n->arguments.size(); ++i) {
+        Type argType = n->arguments[i]->type;
+        Type paramType = valueType(procDescriptor->params[i]->typeDesc->name);
+        if (argType != paramType) {
+            throw ParseException("Semantic error: Incorrect argument type of procedure '"
+                                 + SymbolTable::name(n->proc->name) + "'. Expected: " + typeText(paramType)
+                                 + ", got: " + typeText(argType));
+        }
+    }
+}
+
+std::string SemanticAnalyzer::typeText(Type type) {
+    return SymbolTable::name(typeName(type));
+}
+
+void SemanticAnalyzer::expectBoolean(const Node *n, const std::string &what) {
+    if (n->type != Type::Bool) {
+        throw ParseException("Semantic error: " + what + " must be boolean, got: " + typeText(n->type));
+    }
+}
+
+bool SemanticAnalyzer::isTruthConstant(const VarNode *n) const {
+    // builtin variables of global scope
+    return (n->name == SYM_TRUE || n->name == SYM_FALSE) && n->depth == currentScope->getLevel() - 1;
+}
+
+void SemanticAnalyzer::classifyProcedures() {
+    if (truthWritten) {
+        for (ProcDescriptor *proc : truthReaders) {
+            proc->pure = false;
+        }
+    }
+    // procedure calling impure one is impure too, repeated until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &procCallees : callees) {
+            ProcDescriptor *proc = procCallees.first;
+            if (!proc->pure) {
+                continue;
+            }
+            for (ProcDescriptor *callee : procCallees.second) {
+                if (!callee->pure) {
+                    proc->pure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
 }
 
-std::map<std::string, Scope *> *SemanticAnalyzer::getPrototypes() const {
+SemanticAnalyzer::Prototypes *SemanticAnalyzer::getPrototypes() const {
     return prototypes;
 }
@@ -14,16 +14,16 @@
  */
 class SemanticAnalyzer : public Visitor {
 public:
-    using Prototypes = std::map<std::string, Scope*>;
+    using Prototypes = std::vector<Scope*>; // global scope first, then procedure scopes
     SemanticAnalyzer();
     ~SemanticAnalyzer();
 
-    std::map<std::string, Scope*> *getPrototypes() const;
+    Prototypes *getPrototypes() const;
 
     void visit(const BinOpNode *n);
     void visit(const LogicalOp *n);
-    void visit(const NumNode *n) {}
-    void visit(const UnaryOpNode *n) {}
+    void visit(const NumNode *n) {} // type known from constant
+    void visit(const UnaryOpNode *n);
     void visit(const CompoundNode *n);
     void visit(const AssignNode *n);
     void visit(const IfNode *n);
@@ -39,8 +39,23 @@ public:
     void visit(const ProcCallNode *n);
 
 private:
+    static std::string typeText(Type type);
+    static bool isNumber(Type type) {
+        return type == Type::Int || type == Type::Fraction;
+    }
+    void expectBoolean(const Node *n, const std::string &what);
+    bool isTruthConstant(const VarNode *n) const;
+    void classifyProcedures();
+
     Scope *currentScope ;
     Prototypes *prototypes;
+    Type returnType; // declared return type of procedure being checked
+
+    // purity of procedures, decided when whole program is checked
+    ProcDescriptor *currentProc; // null in main program
+    std::unordered_map<ProcDescriptor*, std::vector<ProcDescriptor*>> callees;
+    std::vector<ProcDescriptor*> truthReaders; // use builtin "true" or "false"
+    bool truthWritten;
 };
 
 #endif //FRACTUS_SEMANTICANALYZER_H
@@ -0,0 +1,176 @@
+//
+// Specializer source file
+// Wiktor Franus, WUT 2017
+//
+
+#include "Specializer.h"
+#include "TypedNodes.h"
+
+Specializer::Specializer(Arena &arena)
+: Rewriter(arena)
+{}
+
+void Specializer::specialize(ProgramNode *program) {
+    program->accept(*this);
+}
+
+template <typename Op>
+void Specializer::replaceBinary(const BinOpNode *n) {
+    replacement = arena.make<TypedBinOpNode<Op>>(*n);
+}
+
+template <typename Op>
+void Specializer::replaceUnary(const UnaryOpNode *n) {
+    replacement = arena.make<TypedUnaryOpNode<Op>>(*n);
+}
+
+template <template <typename> class Comparison>
+void Specializer::replaceComparison(const BinOpNode *n) {
+    switch (n->op) {
+        case EQOP:
+            replaceBinary<Comparison<std::equal_to<>>>(n);
+            break;
+        case NEQOP:
+            replaceBinary<Comparison<std::not_equal_to<>>>(n);
+            break;
+        case LTOP:
+            replaceBinary<Comparison<std::less<>>>(n);
+            break;
+        case LEOP:
+            replaceBinary<Comparison<std::less_equal<>>>(n);
+            break;
+        case GTOP:
+            replaceBinary<Comparison<std::greater<>>>(n);
+            break;
+        case GEOP:
+            replaceBinary<Comparison<std::greater_equal<>>>(n);
+            break;
+        default:
+            break;
+    }
+}
+
+void Specializer::visit(const BinOpNode *n) {
+    rewrite(n->left);
+    rewrite(n->right);
+
+    // both operands have the same type, the analyzer allowed only
+    // operators defined for it
+    switch (n->left->type) {
+        case Type::Int:
+            switch (n->op) {
+                case PLUS:
+                    replaceBinary<IntAdd>(n);
+                    break;
+                case MINUS:
+                    replaceBinary<IntSubtract>(n);
+                    break;
+                case MULTSIGN:
+                    replaceBinary<IntMultiply>(n);
+                    break;
+                case DIVSIGN:
+                    replaceBinary<IntDivide>(n);
+                    break;
+                default:
+                    replaceComparison<WordCompare>(n);
+                    break;
+            }
+            break;
+        case Type::Fraction:
+            switch (n->op) {
+                case PLUS:
+                    replaceBinary<FractAdd>(n);
+                    break;
+                case MINUS:
+                    replaceBinary<FractSubtract>(n);
+                    break;
+                case MULTSIGN:
+                    replaceBinary<FractMultiply>(n);
+                    break;
+                case DIVSIGN:
+                    replaceBinary<FractDivide>(n);
+                    break;
+                default:
+                    replaceComparison<FractCompare>(n);
+                    break;
+            }
+            break;
+        case Type::String:
+            if (n->op == PLUS) {
+                replaceBinary<StringConcat>(n);
+            } else {
+                replaceComparison<StringCompare>(n);
+            }
+            break;
+        case Type::Bool:
+            replaceComparison<WordCompare>(n);
+            break;
+        default:
+            break;
+    }
+}
+
+void Specializer::visit(const LogicalOp *n) {
+    // already evaluated on booleans only
+    rewrite(n->left);
+    rewrite(n->right);
+}
+
+void Specializer::visit(const UnaryOpNode *n) {
+    rewrite(n->expression);
+    if (n->op == NOTSIGN) {
+        replaceUnary<BoolNot>(n);
+    } else if (n->type == Type::Int) {
+        replaceUnary<IntNegate>(n);
+    } else {
+        replaceUnary<FractNegate>(n);
+    }
+}
+
+void Specializer::visit(const CompoundNode *n) {
+    for (Node *const &child : n->children) {
+        rewrite(child);
+    }
+}
+
+void Specializer::visit(const AssignNode *n) {
+    rewrite(n->right);
+}
+
+void Specializer::visit(const IfNode *n) {
+    rewrite(n->condition);
+    rewrite(n->thenNode);
+    if (n->elseNode) {
+        rewrite(n->elseNode);
+    }
+}
+
+void Specializer::visit(const WhileNode *n) {
+    rewrite(n->condition);
+    rewrite(n->statement);
+}
+
+void Specializer::visit(const ReturnNode *n) {
+    rewrite(n->expr);
+}
+
+void Specializer::visit(const ProgramNode *n) {
+    n->block->accept(*this);
+}
+
+void Specializer::visit(const BlockNode *n) {
+    for (ProcDeclNode *proc : n->procDeclarations) {
+        proc->accept(*this);
+    }
+    n->compundStatement->accept(*this);
+}
+
+void Specializer::visit(const ProcDeclNode *n) {
+    n->blockNode->accept(*this);
+}
+
+void Specializer::visit(const ProcCallNode *n) {
+    for (Node *const &arg : n->arguments) {
+        rewrite(arg);
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Rewriting of checked AST into type specialized nodes
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_SPECIALIZER_H
+#define FRACTUS_SPECIALIZER_H
+
+#include "Rewriter.h"
+
+/**
+ * Tree visitor replacing generic operator nodes with nodes specialized
+ * for the operator and static type of operands (see TypedNodes.h).
+ * Runs after SemanticAnalyzer, new nodes are placed in the tree's arena.
+ */
+class Specializer : public Rewriter {
+public:
+    Specializer(Arena &arena);
+
+    void specialize(ProgramNode *program);
+
+    void visit(const BinOpNode *n);
+    void visit(const LogicalOp *n);
+    void visit(const NumNode *n) {}
+    void visit(const UnaryOpNode *n);
+    void visit(const CompoundNode *n);
+    void visit(const AssignNode *n);
+    void visit(const IfNode *n);
+    void visit(const WhileNode *n);
+    void visit(const ReturnNode *n);
+    void visit(const VarNode *n) {}
+    void visit(const ProgramNode *n);
+    void visit(const BlockNode *n);
+    void visit(const VarDeclNode *n) {}
+    void visit(const TypeNode *n) {}
+    void visit(const ParamNode *n) {}
+    void visit(const ProcDeclNode *n);
+    void visit(const ProcCallNode *n);
+
+private:
+    template <typename Op>
+    void replaceBinary(const BinOpNode *n);
+    template <typename Op>
+    void replaceUnary(const UnaryOpNode *n);
+    template <template <typename> class Comparison>
+    void replaceComparison(const BinOpNode *n);
+};
+
+#endif //FRACTUS_SPECIALIZER_H
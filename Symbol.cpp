@@ -0,0 +1,40 @@
+//
+// SymbolTable source file
+// Wiktor Franus, WUT 2017
+//
+
+#include "Symbol.h"
+
+SymbolTable::SymbolTable() {
+    // same order as PredefinedSymbol
+    for (const char *name : { "global", "integer", "boolean", "string", "fraction",
+                              "void", "print", "read", "true", "false" }) {
+        names.emplace_back(name);
+        ids.emplace(names.back(), static_cast<Symbol>(names.size() - 1));
+    }
+}
+
+SymbolTable &SymbolTable::instance() {
+    static SymbolTable table;
+    return table;
+}
+
+Symbol SymbolTable::intern(std::string_view name) {
+    SymbolTable &table = instance();
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    table.names.emplace_back(name);
+    Symbol symbol = static_cast<Symbol>(table.names.size() - 1);
+    table.ids.emplace(table.names.back(), symbol);
+    return symbol;
+}
+
+const std::string &SymbolTable::name(Symbol symbol) {
+    return instance().names[symbol];
+}
+
+size_t SymbolTable::size() {
+    return instance().names.size();
+}
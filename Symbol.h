@@ -0,0 +1,54 @@
+//
+// Interned identifiers
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_SYMBOL_H
+#define FRACTUS_SYMBOL_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// identifier replaced by its number in SymbolTable
+using Symbol = uint32_t;
+
+/**
+ * Names known to the interpreter, interned before any other
+ */
+enum PredefinedSymbol : Symbol {
+    SYM_GLOBAL,
+    SYM_INTEGER,
+    SYM_BOOLEAN,
+    SYM_STRING,
+    SYM_FRACTION,
+    SYM_VOID,
+    SYM_PRINT,
+    SYM_READ,
+    SYM_TRUE,
+    SYM_FALSE,
+    SYM_PREDEFINED_COUNT
+};
+
+/**
+ * Global table of identifiers. Each distinct name is stored once
+ * and gets a small number, later phases compare and hash only numbers.
+ */
+class SymbolTable {
+public:
+    static Symbol intern(std::string_view name);
+    static const std::string &name(Symbol symbol);
+    // number of symbols interned so far, every symbol is lower
+    static size_t size();
+
+private:
+    SymbolTable();
+    static SymbolTable &instance();
+
+    std::deque<std::string> names;                   // never moved, keys below point into it
+    std::unordered_map<std::string_view, Symbol> ids;
+};
+
+#endif //FRACTUS_SYMBOL_H
@@ -0,0 +1,171 @@
+//
+// Expression nodes specialized for types of their operands
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_TYPEDNODES_H
+#define FRACTUS_TYPEDNODES_H
+
+#include <functional>
+#include <stdexcept>
+
+#include "Ast.h"
+#include "Numeric.h"
+
+/**
+ * Operations on values of statically known type.
+ * Operands were type checked by SemanticAnalyzer, so no tag is examined
+ * except for the inline fraction fast path.
+ */
+
+struct IntAdd {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromInt(l.intVal() + r.intVal());
+    }
+};
+
+struct IntSubtract {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromInt(l.intVal() - r.intVal());
+    }
+};
+
+struct IntMultiply {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromInt(l.intVal() * r.intVal());
+    }
+};
+
+struct IntDivide {
+    static ValType apply(const ValType &l, const ValType &r) {
+        if (r.intVal() == 0) {
+            throw std::runtime_error("Operand must be different than 0.");
+        }
+        return ValType::fromInt(wrappingDivide(l.intVal(), r.intVal()));
+    }
+};
+
+struct IntNegate {
+    static ValType apply(const ValType &v) {
+        return ValType::fromInt(-v.intVal());
+    }
+};
+
+struct FractAdd {
+    static ValType apply(const ValType &l, const ValType &r) {
+        Fraction result;
+        if (l.isSmallFraction() && r.isSmallFraction()
+            && checkedAdd(l.smallFractVal(), r.smallFractVal(), result)) {
+            return ValType::fromFraction(result);
+        }
+        return ValType::fromFraction(l.fractVal() + r.fractVal());
+    }
+};
+
+struct FractSubtract {
+    static ValType apply(const ValType &l, const ValType &r) {
+        Fraction result;
+        if (l.isSmallFraction() && r.isSmallFraction()
+            && checkedSubtract(l.smallFractVal(), r.smallFractVal(), result)) {
+            return ValType::fromFraction(result);
+        }
+        return ValType::fromFraction(l.fractVal() - r.fractVal());
+    }
+};
+
+struct FractMultiply {
+    static ValType apply(const ValType &l, const ValType &r) {
+        Fraction result;
+        if (l.isSmallFraction() && r.isSmallFraction()
+            && checkedMultiply(l.smallFractVal(), r.smallFractVal(), result)) {
+            return ValType::fromFraction(result);
+        }
+        return ValType::fromFraction(l.fractVal() * r.fractVal());
+    }
+};
+
+struct FractDivide {
+    static ValType apply(const ValType &l, const ValType &r) {
+        Fraction result;
+        if (l.isSmallFraction() && r.isSmallFraction()) {
+            if (r.smallFractVal().isZero()) {
+                throw std::runtime_error("Operand must be different than 0.");
+            }
+            if (checkedDivide(l.smallFractVal(), r.smallFractVal(), result)) {
+                return ValType::fromFraction(result);
+            }
+        }
+        // big fraction is never zero
+        return ValType::fromFraction(l.fractVal() / r.fractVal());
+    }
+};
+
+struct FractNegate {
+    static ValType apply(const ValType &v) {
+        return ValType::fromFraction(-v.fractVal());
+    }
+};
+
+struct StringConcat {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromString(l.stringVal() + r.stringVal());
+    }
+};
+
+struct BoolNot {
+    static ValType apply(const ValType &v) {
+        return ValType::fromBool(!v.boolVal());
+    }
+};
+
+// comparisons of values stored in one word (bool and integer)
+template <typename Compare>
+struct WordCompare {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromBool(Compare()(l.intVal(), r.intVal()));
+    }
+};
+
+template <typename Compare>
+struct FractCompare {
+    static ValType apply(const ValType &l, const ValType &r) {
+        if (l.isSmallFraction() && r.isSmallFraction()) {
+            return ValType::fromBool(Compare()(l.smallFractVal(), r.smallFractVal()));
+        }
+        return ValType::fromBool(Compare()(l.fractVal(), r.fractVal()));
+    }
+};
+
+template <typename Compare>
+struct StringCompare {
+    static ValType apply(const ValType &l, const ValType &r) {
+        return ValType::fromBool(Compare()(l.stringVal(), r.stringVal()));
+    }
+};
+
+/**
+ * Nodes evaluating one operation for one type of operands.
+ * They stay BinOpNode/UnaryOpNode for visitors.
+ */
+
+template <typename Op>
+struct TypedBinOpNode : public BinOpNode {
+    TypedBinOpNode(const BinOpNode &n) : BinOpNode(n) {}
+
+    ValType evaluate(Interpreter *interpreter) {
+        ValType leftRes = left->evaluate(interpreter);
+        ValType rightRes = right->evaluate(interpreter);
+        return Op::apply(leftRes, rightRes);
+    }
+};
+
+template <typename Op>
+struct TypedUnaryOpNode : public UnaryOpNode {
+    TypedUnaryOpNode(const UnaryOpNode &n) : UnaryOpNode(n) {}
+
+    ValType evaluate(Interpreter *interpreter) {
+        return Op::apply(expression->evaluate(interpreter));
+    }
+};
+
+#endif //FRACTUS_TYPEDNODES_H
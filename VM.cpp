@@ -0,0 +1,358 @@
+//
+// VM source file
+// Wiktor Franus, WUT 2017
+//
+
+#include <algorithm>
+
+#include "VM.h"
+#include "Interpreter.h"
+
+// labels as values are a GCC and Clang extension, elsewhere instructions are dispatched by switch
+#if defined(__GNUC__) && !defined(FRACTUS_SWITCH_DISPATCH)
+#define FRACTUS_COMPUTED_GOTO
+#endif
+
+// free stack slots required for temporaries of a frame
+static const size_t STACK_HEADROOM = 256;
+// initial sizes, both grow twice when they are full
+static const size_t INITIAL_STACK = 4096;
+static const size_t INITIAL_FRAMES = 256;
+
+VM::VM(Interpreter *interpreter, const CompiledProgram &program, size_t stackMemory)
+: interpreter(interpreter)
+, program(program)
+, globals(program.globals)
+, stack(INITIAL_STACK)
+, stackTop(stack.data())
+, stackMemory(stackMemory)
+, memo(interpreter->getMemo())
+{
+    frames.reserve(INITIAL_FRAMES);
+}
+
+void VM::binaryOp(Token op) {
+    ValType &left = stackTop[-2];
+    left = interpreter->binaryOperation(op, left, stackTop[-1]);
+    --stackTop;
+}
+
+bool VM::fits(size_t stackSize, size_t frameCount) const {
+    return stackSize * sizeof(ValType) + frameCount * sizeof(CallFrame) <= stackMemory;
+}
+
+void VM::reserve(const ValType *top, const ProcPrototype &proc) {
+    size_t used = static_cast<size_t>(stackTop - stack.data());
+    size_t required = static_cast<size_t>(top - stack.data()) + STACK_HEADROOM;
+    size_t stackSize = stack.size() < required ? std::max(stack.size() * 2, required) : stack.size();
+    size_t frameCount = frames.size() < frames.capacity() ? frames.capacity() : frames.capacity() * 2;
+    if (!fits(stackSize, frameCount)) {
+        // close to the limit both are scaled down together to the largest
+        // size fitting the limit, so they grow once more, not per call
+        size_t stackNeeded = std::max(stack.size(), required);
+        size_t frameNeeded = std::max(frames.capacity(), frames.size() + 1);
+        if (!fits(stackNeeded, frameNeeded)) {
+            throw std::runtime_error("Stack overflow in procedure: " + proc.name);
+        }
+        // binary search of the part of doubled growth that fits
+        size_t low = 0, high = 1024;
+        auto scaled = [](size_t needed, size_t doubled, size_t part) {
+            return needed + (doubled - needed) * part / 1024;
+        };
+        while (low < high) {
+            size_t part = (low + high + 1) / 2;
+            if (fits(scaled(stackNeeded, stackSize, part), scaled(frameNeeded, frameCount, part))) {
+                low = part;
+            } else {
+                high = part - 1;
+            }
+        }
+        stackSize = scaled(stackNeeded, stackSize, low);
+        frameCount = scaled(frameNeeded, frameCount, low);
+    }
+
+    frames.reserve(frameCount);
+    if (stackSize > stack.size()) {
+        std::vector<ValType> grown(stackSize);
+        std::move(stack.begin(), stack.begin() + used, grown.begin());
+        // frames keep pointers into the stack
+        ValType *oldBase = stack.data();
+        stack.swap(grown);
+        for (CallFrame &frame : frames) {
+            frame.slots = stack.data() + (frame.slots - oldBase);
+        }
+        stackTop = stack.data() + used;
+    }
+}
+
+void VM::run() {
+    frames.push_back({nullptr, nullptr, stackTop, nullptr});
+    const uint8_t *ip = program.main.code.data();
+    const ValType *constants = program.main.constants.data();
+    ValType *slots = stackTop;
+    const ValType *stackLimit = stack.data() + stack.size() - STACK_HEADROOM;
+
+// after the stack has grown
+#define RELOAD_STACK()                                                      \
+    do {                                                                    \
+        slots = frames.back().slots;                                        \
+        stackLimit = stack.data() + stack.size() - STACK_HEADROOM;          \
+    } while (false)
+
+#define READ_SHORT() (ip += 2, static_cast<uint16_t>((ip[-2] << 8) | ip[-1]))
+
+// integer fast path, generic operation otherwise
+#define INT_BINARY_OP(token, setter, expr)                                  \
+    do {                                                                    \
+        ValType &l = stackTop[-2];                                          \
+        const ValType &r = stackTop[-1];                                    \
+        if (l.type() == Type::Int && r.type() == Type::Int) {               \
+            l.setter(expr);                                                 \
+            --stackTop;                                                     \
+        } else {                                                            \
+            binaryOp(token);                                                \
+        }                                                                   \
+    } while (false)
+
+#ifdef FRACTUS_COMPUTED_GOTO
+    // threaded code: every instruction jumps straight to the next one's handler
+    static void *const handlers[] = {
+        &&op_Constant,
+        &&op_GetLocal,
+        &&op_SetLocal,
+        &&op_GetGlobal,
+        &&op_SetGlobal,
+        &&op_Pop,
+        &&op_Add,
+        &&op_Subtract,
+        &&op_Multiply,
+        &&op_Divide,
+        &&op_Equal,
+        &&op_NotEqual,
+        &&op_Less,
+        &&op_LessEqual,
+        &&op_Greater,
+        &&op_GreaterEqual,
+        &&op_Negate,
+        &&op_Not,
+        &&op_Jump,
+        &&op_JumpIfFalse,
+        &&op_JumpIfFalseOrPop,
+        &&op_JumpIfTrueOrPop,
+        &&op_Loop,
+        &&op_Call,
+        &&op_TailCall,
+        &&op_Return,
+        &&op_MissingReturn,
+        &&op_Print,
+        &&op_ReadLocal,
+        &&op_ReadGlobal,
+        &&op_Halt
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(OpCode::Halt) + 1,
+                  "handler for every opcode, in order of OpCode");
+#define CASE(op) op_##op
+#define NEXT() goto *handlers[*ip++]
+    NEXT();
+    {
+        {
+#else
+#define CASE(op) case OpCode::op
+#define NEXT() break
+    for (;;) {
+        switch (static_cast<OpCode>(*ip++)) {
+#endif
+            CASE(Constant):
+                *stackTop++ = constants[READ_SHORT()];
+                NEXT();
+            CASE(GetLocal):
+                *stackTop++ = slots[READ_SHORT()];
+                NEXT();
+            CASE(SetLocal):
+                --stackTop;
+                slots[READ_SHORT()] = std::move(*stackTop);
+                NEXT();
+            CASE(GetGlobal):
+                *stackTop++ = globals[READ_SHORT()];
+                NEXT();
+            CASE(SetGlobal):
+                --stackTop;
+                globals[READ_SHORT()] = std::move(*stackTop);
+                NEXT();
+            CASE(Pop):
+                --stackTop;
+                NEXT();
+            CASE(Add):
+                INT_BINARY_OP(PLUS, setInt, l.intVal() + r.intVal());
+                NEXT();
+            CASE(Subtract):
+                INT_BINARY_OP(MINUS, setInt, l.intVal() - r.intVal());
+                NEXT();
+            CASE(Multiply):
+                INT_BINARY_OP(MULTSIGN, setInt, l.intVal() * r.intVal());
+                NEXT();
+            CASE(Divide):
+                // division by zero has to be reported
+                binaryOp(DIVSIGN);
+                NEXT();
+            CASE(Equal):
+                INT_BINARY_OP(EQOP, setBool, l.intVal() == r.intVal());
+                NEXT();
+            CASE(NotEqual):
+                INT_BINARY_OP(NEQOP, setBool, l.intVal() != r.intVal());
+                NEXT();
+            CASE(Less):
+                INT_BINARY_OP(LTOP, setBool, l.intVal() < r.intVal());
+                NEXT();
+            CASE(LessEqual):
+                INT_BINARY_OP(LEOP, setBool, l.intVal() <= r.intVal());
+                NEXT();
+            CASE(Greater):
+                INT_BINARY_OP(GTOP, setBool, l.intVal() > r.intVal());
+                NEXT();
+            CASE(GreaterEqual):
+                INT_BINARY_OP(GEOP, setBool, l.intVal() >= r.intVal());
+                NEXT();
+            CASE(Negate):
+                stackTop[-1] = interpreter->unaryOperation(MINUS, stackTop[-1]);
+                NEXT();
+            CASE(Not):
+                stackTop[-1].setBool(!stackTop[-1].boolVal());
+                NEXT();
+            CASE(Jump): {
+                uint16_t offset = READ_SHORT();
+                ip += offset;
+                NEXT();
+            }
+            CASE(JumpIfFalse): {
+                uint16_t offset = READ_SHORT();
+                --stackTop;
+                if (!stackTop->boolVal()) {
+                    ip += offset;
+                }
+                NEXT();
+            }
+            CASE(JumpIfFalseOrPop): {
+                uint16_t offset = READ_SHORT();
+                if (!stackTop[-1].boolVal()) {
+                    ip += offset;
+                } else {
+                    --stackTop;
+                }
+                NEXT();
+            }
+            CASE(JumpIfTrueOrPop): {
+                uint16_t offset = READ_SHORT();
+                if (stackTop[-1].boolVal()) {
+                    ip += offset;
+                } else {
+                    --stackTop;
+                }
+                NEXT();
+            }
+            CASE(Loop): {
+                uint16_t offset = READ_SHORT();
+                ip -= offset;
+                NEXT();
+            }
+            CASE(Call): {
+                const ProcPrototype &proc = program.procedures[READ_SHORT()];
+                const ProcPrototype *memoized = nullptr;
+                if (memo && proc.pure) {
+                    const ValType *cached = memo->find(&proc, stackTop - proc.paramCount, proc.paramCount);
+                    if (cached) {
+                        stackTop -= proc.paramCount;
+                        *stackTop++ = *cached;
+                        NEXT();
+                    }
+                    memoArgs.insert(memoArgs.end(), stackTop - proc.paramCount, stackTop);
+                    memoized = &proc;
+                }
+                if (frames.size() == frames.capacity() || stackTop + proc.slots.size() > stackLimit) {
+                    reserve(stackTop + proc.slots.size(), proc);
+                    RELOAD_STACK();
+                }
+                frames.back().ip = ip;
+
+                // arguments become parameters
+                ValType *base = stackTop - proc.paramCount;
+                for (size_t i = proc.paramCount; i < proc.slots.size(); ++i) {
+                    base[i] = proc.slots[i];
+                }
+                stackTop = base + proc.slots.size();
+
+                frames.push_back({&proc, nullptr, base, memoized});
+                ip = proc.chunk.code.data();
+                constants = proc.chunk.constants.data();
+                slots = base;
+                NEXT();
+            }
+            CASE(TailCall): {
+                const ProcPrototype &proc = program.procedures[READ_SHORT()];
+                if (slots + proc.slots.size() > stackLimit) {
+                    reserve(slots + proc.slots.size(), proc);
+                    RELOAD_STACK();
+                }
+
+                // arguments lie above the frame, they become parameters of the callee in its place
+                std::move(stackTop - proc.paramCount, stackTop, slots);
+                for (size_t i = proc.paramCount; i < proc.slots.size(); ++i) {
+                    slots[i] = proc.slots[i];
+                }
+                stackTop = slots + proc.slots.size();
+
+                frames.back().proc = &proc;
+                ip = proc.chunk.code.data();
+                constants = proc.chunk.constants.data();
+                NEXT();
+            }
+            CASE(Return): {
+                if (frames.size() == 1) {
+                    // return from main program
+                    return;
+                }
+                ValType result = std::move(stackTop[-1]);
+                const ProcPrototype *memoized = frames.back().memoized;
+                if (memoized) {
+                    // result of tail calls is the result of the memoized call
+                    const ValType *args = memoArgs.data() + memoArgs.size() - memoized->paramCount;
+                    memo->insert(memoized, args, memoized->paramCount, result);
+                    memoArgs.resize(memoArgs.size() - memoized->paramCount);
+                }
+                stackTop = slots;
+                *stackTop++ = std::move(result);
+                frames.pop_back();
+
+                const CallFrame &caller = frames.back();
+                const Chunk &callerChunk = caller.proc ? caller.proc->chunk : program.main;
+                ip = caller.ip;
+                constants = callerChunk.constants.data();
+                slots = caller.slots;
+                NEXT();
+            }
+            CASE(MissingReturn):
+                throw std::runtime_error("Procedure " + frames.back().proc->name
+                                         + " ended without returning a value.");
+            CASE(Print):
+                std::cout << stackTop[-1] << std::endl;
+                stackTop[-1] = ValType();
+                NEXT();
+            CASE(ReadLocal):
+                std::cin >> slots[READ_SHORT()];
+                *stackTop++ = ValType();
+                NEXT();
+            CASE(ReadGlobal):
+                std::cin >> globals[READ_SHORT()];
+                *stackTop++ = ValType();
+                NEXT();
+            CASE(Halt):
+                return;
+        }
+    }
+
+#undef NEXT
+#undef CASE
+#undef RELOAD_STACK
+#undef INT_BINARY_OP
+#undef READ_SHORT
+}
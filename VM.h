@@ -0,0 +1,50 @@
+//
+// Stack based virtual machine executing FraCtuS bytecode
+// Wiktor Franus, WUT 2017
+//
+
+#ifndef FRACTUS_VM_H
+#define FRACTUS_VM_H
+
+#include "Bytecode.h"
+#include "MemoCache.h"
+#include "Scanner.h"
+
+class Interpreter;
+
+/**
+ * Bytecode executor. Local variables of a call live
+ * on the value stack, starting at frame's base slot.
+ * Value stack and call frames are heap allocated and grow on demand,
+ * so depth of recursion is bounded only by their memory limit.
+ */
+class VM {
+public:
+    VM(Interpreter *interpreter, const CompiledProgram &program, size_t stackMemory);
+    void run();
+
+private:
+    struct CallFrame {
+        const ProcPrototype *proc;
+        const uint8_t *ip;      // return address when frame is suspended by a call
+        ValType *slots;
+        const ProcPrototype *memoized; // call whose result is cached when it returns
+    };
+
+    void binaryOp(Token op);
+    // makes room for values up to top and for one more frame, may move the stack
+    void reserve(const ValType *top, const ProcPrototype &proc);
+    bool fits(size_t stackSize, size_t frameCount) const;
+
+    Interpreter *interpreter;
+    const CompiledProgram &program;
+    std::vector<ValType> globals;
+    std::vector<ValType> stack;
+    ValType *stackTop;
+    std::vector<CallFrame> frames;
+    size_t stackMemory; // limit of bytes taken by value stack and frames together
+    MemoCache *memo;
+    std::vector<ValType> memoArgs; // arguments of memoized calls in progress
+};
+
+#endif //FRACTUS_VM_H
@@ -1,9 +1,15 @@
 #include <iostream>
+#include <fstream>
+#include <cctype>
+#include <cstdlib>
 #include "Reader.h"
 #include "Scanner.h"
 #include "Parser.h"
 #include "SemanticAnalyzer.h"
+#include "Optimizer.h"
+#include "Specializer.h"
 #include "Interpreter.h"
+#include "CppGenerator.h"
 
 std::map<Token, std::string> mappings = {
     {PROGRAM,     "PROGRAM"},
@@ -53,19 +59,51 @@ std::map<Token, std::string> mappings = {
 };
 
 void printErrorLine(const Scanner &scanner);
+std::string cppFileName(const std::string &fileName);
 void printExceptionInfo(const Scanner &scanner, const Parser &parser);
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
+    ExecutionMode mode = ExecutionMode::TreeWalking;
+    int optimizationLevel = 0;
+    size_t stackMemory = Interpreter::DEFAULT_STACK_MEMORY;
+    size_t memoEntries = 0;
+    bool emitCpp = false;
+    std::string fileName;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--adaptive") {
+            mode = ExecutionMode::Adaptive;
+        } else if (arg == "--vm") {
+            mode = ExecutionMode::Bytecode;
+        } else if (arg == "--reg") {
+            mode = ExecutionMode::Registers;
+        } else if (arg == "--jit") {
+            mode = ExecutionMode::Jit;
+        } else if (arg.size() == 3 && arg.compare(0, 2, "-O") == 0 && isdigit(arg[2])) {
+            optimizationLevel = arg[2] - '0';
+        } else if (arg.size() > 8 && arg.compare(0, 8, "--stack=") == 0 && isdigit(arg[8])) {
+            // limit in megabytes
+            stackMemory = std::strtoul(arg.c_str() + 8, nullptr, 10) << 20;
+        } else if (arg == "--emit-cpp") {
+            emitCpp = true;
+        } else if (arg == "--memo") {
+            memoEntries = Interpreter::DEFAULT_MEMO_ENTRIES;
+        } else if (arg.size() > 7 && arg.compare(0, 7, "--memo=") == 0 && isdigit(arg[7])) {
+            memoEntries = std::strtoul(arg.c_str() + 7, nullptr, 10);
+        } else {
+            fileName = arg;
+        }
+    }
+    if (fileName.empty()) {
         std::cout << "Nie podano nazwy pliku wejsciowego" << std::endl;
         return 0;
     }
-    Reader reader(argv[1]);
+    Reader reader(fileName);
     Scanner scanner(&reader);
     Parser parser(scanner);
     SemanticAnalyzer semAnalyzer;
 
-    ProgramNode *tree = nullptr;
+    SyntaxTree tree;
     try {
         tree = parser.parse();
         std::cout << "*** No lexical errors ***\n" << std::endl;
@@ -84,29 +122,41 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    if (tree) {
+    if (tree.program) {
         try {
-            semAnalyzer.visit(tree);
+            semAnalyzer.visit(tree.program);
             std::cout << "*** No semantic errors ***\n" << std::endl;
+            Optimizer(tree.arena, optimizationLevel).optimize(tree.program);
+            if (mode == ExecutionMode::TreeWalking && !emitCpp) {
+                Specializer(tree.arena).specialize(tree.program);
+            }
         } catch (ParseException e) {
             std::cout << e.what() << std::endl;
             return 0;
         }
     }
+    if (emitCpp && tree.program) {
+        // program is translated instead of being run
+        std::string outputName = cppFileName(fileName);
+        std::ofstream output(outputName);
+        output << CppGenerator().generate(tree.program);
+        if (!output) {
+            std::cout << "Cannot write " << outputName << std::endl;
+            return 0;
+        }
+        std::cout << "C++ source written to " << outputName << std::endl;
+        return 0;
+    }
     std::cout << "***********************" << std::endl;
     std::cout << "Interpreting...\n" << std::endl;
-    Interpreter interpreter(semAnalyzer.getPrototypes(), tree);
+    Interpreter interpreter(semAnalyzer.getPrototypes(), tree.program, mode, stackMemory, memoEntries);
     try {
         interpreter.interpret();
     } catch (std::runtime_error e) {
         std::cout<< e.what() << std::endl;
     }
 
-    // cleaning
-    {
-        std::cout << std::endl;
-        delete tree;
-    }
+    std::cout << std::endl;
     return 0;
 }
 
@@ -121,4 +171,15 @@ void printExceptionInfo(const Scanner &scanner, const Parser &parser) {
     if (scanner.getCurrentSymbol() == IDENTIFIER) {
         std::cout << scanner.getLastString() << std::endl;
     }
-}
\ No newline at end of file
+}
+std::string cppFileName(const std::string &fileName) {
+    // extension of the source file is replaced, one in a directory name is not
+    size_t period = fileName.rfind('.');
+    size_t slash = fileName.rfind('/');
+    std::string base = fileName;
+    if (period != std::string::npos && (slash == std::string::npos || period > slash)) {
+        base = fileName.substr(0, period);
+    }
+    // source named .cpp is not overwritten
+    return base + ".cpp" == fileName ? fileName + ".cpp" : base + ".cpp";
+}
@@ -0,0 +1,30 @@
+#
+# Literals of a bytecode chunk share constants, so any number of repeated
+# ones fits, while more than 65536 different ones are reported at compile time.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(count 66000)
+
+function(run name statements result)
+    file(WRITE ${WORK_DIR}/${name}.txt "program ${name};\n    var s: integer;\n    begin\n${statements}        print(s)\n    end.\n")
+    execute_process(COMMAND ${FRACTUS} --vm ${name}.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output ERROR_QUIET)
+    set(${result} "${output}" PARENT_SCOPE)
+endfunction()
+
+string(REPEAT "        s = s + 1;\n" ${count} repeated)
+run(repeated "${repeated}" output)
+if (NOT output MATCHES "Interpreting...\n\n${count}\n")
+    message(FATAL_ERROR "${count} equal literals: unexpected output\n${output}")
+endif()
+
+set(different "")
+foreach (i RANGE 1 ${count})
+    string(APPEND different "        s = ${i};\n")
+endforeach()
+run(different "${different}" output)
+if (NOT output MATCHES "Runtime error: Too many constants in one procedure.")
+    message(FATAL_ERROR "${count} different literals: limit not reported\n${output}")
+endif()
@@ -0,0 +1,49 @@
+#
+# The tree walker nests calls as deep as its stack memory and native stack
+# allow, deeper ones are reported instead of crashing the interpreter.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(run name depth mode result)
+    file(WRITE ${WORK_DIR}/${name}.txt "program ${name};
+    integer D(integer n);
+        var a, b, c, d, e, f, g, h: integer;
+        begin
+            if (n == 0) then
+                return 0;
+            return 1 + D(n - 1)
+        end;
+
+    begin
+        print(D(${depth}))
+    end.
+")
+    execute_process(COMMAND ${FRACTUS} ${mode} ${name}.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if (NOT status EQUAL 0)
+        message(FATAL_ERROR "${name} ${mode}: exited with ${status}\n${output}")
+    endif()
+    set(${result} "${output}" PARENT_SCOPE)
+endfunction()
+
+foreach (mode "" --adaptive)
+    run(nested 5000 "${mode}" output)
+    if (NOT output MATCHES "Interpreting...\n\n5000\n")
+        message(FATAL_ERROR "5000 nested calls, mode '${mode}': unexpected output\n${output}")
+    endif()
+endforeach()
+
+run(unbounded 100000000 "" output)
+if (NOT output MATCHES "Runtime error: Stack overflow in procedure: D")
+    message(FATAL_ERROR "unbounded recursion: overflow not reported\n${output}")
+endif()
+
+# near the limit the stacks grow once more, not on every call
+foreach (mode "" --vm)
+    run(limited 10000 "${mode};--stack=1" output)
+    if (NOT output MATCHES "Runtime error: Stack overflow in procedure: D")
+        message(FATAL_ERROR "10000 nested calls in 1 MB, mode '${mode}': overflow not reported\n${output}")
+    endif()
+endforeach()
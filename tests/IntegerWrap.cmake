@@ -0,0 +1,62 @@
+#
+# Integer overflow wraps around the same in every execution mode and in
+# generated C++ built with -fwrapv, INT_MIN / -1 included.
+# Variables: FRACTUS (interpreter executable), WORK_DIR,
+# CXX (C++ compiler), SOURCE_DIR, CORE (fractus_core library)
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(WRITE ${WORK_DIR}/wrap.txt "program wrap;
+    var i, x, m, q: integer;
+
+    integer Square(integer n);
+        begin
+            return n * n
+        end;
+
+    integer Quotient(integer a, integer b);
+        begin
+            return a / b
+        end;
+
+    begin
+        x = 2147483647;
+        m = 0 - 1;
+        while (i < 2000) do
+            begin
+                x = x + 1 - 1;
+                q = Quotient(x + 1, m);
+                i = i + Square(1)
+            end;
+        print(q);
+        q = (x + 1) / m;
+        print(q);
+        print(x + 1);
+        print(0 - x - 2);
+        print(Square(65536) + 1);
+        x = 0 - x - 1;
+        x = -x;
+        print(x)
+    end.
+")
+
+set(values "-2147483648\n-2147483648\n-2147483648\n2147483647\n1\n-2147483648\n")
+set(expected "Interpreting...\n\n${values}")
+foreach (mode "" --adaptive --vm --reg --jit -O2)
+    execute_process(COMMAND ${FRACTUS} ${mode} wrap.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if (NOT status EQUAL 0 OR NOT output MATCHES "${expected}")
+        message(FATAL_ERROR "mode '${mode}': unexpected output\n${output}")
+    endif()
+endforeach()
+
+execute_process(COMMAND ${FRACTUS} --emit-cpp wrap.txt WORKING_DIRECTORY ${WORK_DIR} OUTPUT_QUIET)
+execute_process(COMMAND ${CXX} -O2 -fwrapv -std=c++17 -I${SOURCE_DIR} wrap.cpp ${CORE} -o wrap
+                WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE status ERROR_VARIABLE errors)
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "generated C++ does not compile\n${errors}")
+endif()
+execute_process(COMMAND ${WORK_DIR}/wrap OUTPUT_VARIABLE output RESULT_VARIABLE status)
+if (NOT status EQUAL 0 OR NOT output STREQUAL "${values}")
+    message(FATAL_ERROR "generated C++: unexpected output\n${output}")
+endif()
@@ -0,0 +1,129 @@
+#
+# Programs which get hot enough to be compiled by the JIT print the same
+# with --jit as in the other modes: wide frames, tail calls, recursion
+# deeper than native code allows and errors raised in native code.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# output of first mode is expected from the following ones
+function(compare name expected modes)
+    set(reference "")
+    foreach (mode ${modes})
+        if (mode STREQUAL "walker")
+            set(mode "")
+        endif()
+        execute_process(COMMAND ${FRACTUS} ${mode} ${name}.txt
+                        WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+        if (NOT status EQUAL 0)
+            message(FATAL_ERROR "${name} ${mode}: exited with ${status}\n${output}")
+        endif()
+        if (reference STREQUAL "")
+            if (NOT output MATCHES "Interpreting...\n\n${expected}")
+                message(FATAL_ERROR "${name} ${mode}: unexpected output\n${output}")
+            endif()
+            set(reference "${output}")
+        elseif (NOT output STREQUAL reference)
+            message(FATAL_ERROR "${name} ${mode}: output differs\n${output}\nexpected\n${reference}")
+        endif()
+    endforeach()
+endfunction()
+
+# more integer registers than frame initialization stores one by one
+set(locals "a0")
+set(body "            a0 = n;\n")
+foreach (i RANGE 1 39)
+    math(EXPR previous "${i} - 1")
+    string(APPEND locals ", a${i}")
+    string(APPEND body "            a${i} = a${previous} + ${i};\n")
+endforeach()
+file(WRITE ${WORK_DIR}/wide.txt "program wide;
+    var i, s: integer;
+
+    integer Wide(integer n);
+        var ${locals}: integer;
+        begin
+${body}            return a39
+        end;
+
+    begin
+        while (i < 2000) do
+            begin
+                s = s + Wide(i) - Wide(i + 1);
+                i = i + 1
+            end;
+        print(s);
+        print(Wide(7))
+    end.
+")
+compare(wide "-2000\n787\n" "walker;--vm;--reg;--jit")
+
+# tail calls of native code reuse the frame
+file(WRITE ${WORK_DIR}/tail.txt "program tail;
+    var i, s: integer;
+
+    integer Sum(integer n, integer acc);
+        begin
+            if (n == 0) then
+                return acc;
+            return Sum(n - 1, acc + n)
+        end;
+
+    begin
+        while (i < 300) do
+            begin
+                s = s + Sum(i, 0);
+                i = i + 1
+            end;
+        print(s);
+        print(Sum(60000, 0))
+    end.
+")
+compare(tail "4499950\n1800030000\n" "walker;--vm;--reg;--jit")
+
+# native calls nested deeper than NATIVE_DEPTH_MAX continue in the VM once
+# the first deep call has grown register banks, too deep for the tree walker
+file(WRITE ${WORK_DIR}/deep.txt "program deep;
+    var i, s: integer;
+
+    integer Depth(integer n);
+        begin
+            if (n == 0) then
+                return 0;
+            return Depth(n - 1) + 1
+        end;
+
+    begin
+        while (i < 200) do
+            begin
+                s = s + Depth(10);
+                i = i + 1
+            end;
+        print(s);
+        print(Depth(40000));
+        print(Depth(40000))
+    end.
+")
+compare(deep "2000\n40000\n40000\n" "--vm;--reg;--jit")
+
+# division by zero in native code is reported by the VM
+file(WRITE ${WORK_DIR}/zero.txt "program zero;
+    var i, s: integer;
+
+    integer Divide(integer a, integer b);
+        begin
+            return a / b
+        end;
+
+    begin
+        i = 300;
+        while (i >= 0) do
+            begin
+                s = s + Divide(600, i);
+                i = i - 1
+            end;
+        print(s)
+    end.
+")
+compare(zero "Runtime error: Operand must be different than 0.\n" "walker;--vm;--reg;--jit")
@@ -0,0 +1,49 @@
+#
+# Nested procedures of different procedures may share a name, each one
+# keeps its own frame in every mode.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(WRITE ${WORK_DIR}/nested.txt "program nested;
+    var r: integer;
+
+    integer A(integer n);
+        integer H(integer m);
+            begin
+                return m + 1
+            end;
+
+        begin
+            return H(n)
+        end;
+
+    integer B(integer n);
+        integer H(string s, integer m);
+            var x, y, z: integer;
+            begin
+                y = 9;
+                x = m;
+                z = x * 10 + y;
+                return z
+            end;
+
+        begin
+            return H(\"b\", n)
+        end;
+
+    begin
+        r = A(1) + B(10) - 2;
+        print(r);
+        print(B(10))
+    end.
+")
+
+set(expected "Interpreting...\n\n109\n109\n")
+foreach (mode "" --adaptive --vm --reg --jit)
+    execute_process(COMMAND ${FRACTUS} ${mode} nested.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if (NOT status EQUAL 0 OR NOT output MATCHES "${expected}")
+        message(FATAL_ERROR "mode '${mode}': unexpected output\n${output}")
+    endif()
+endforeach()
@@ -0,0 +1,52 @@
+#
+# Operands are evaluated left to right in every mode: a main program variable
+# is read before a call in a later operand changes it.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(WRITE ${WORK_DIR}/order.txt "program order;
+    var g, r: integer;
+
+    integer Bump(integer k);
+        begin
+            g = g + k;
+            return k
+        end;
+
+    integer Difference(integer a, integer b);
+        begin
+            return a - b
+        end;
+
+    begin
+        g = 10;
+        r = g + Bump(2);
+        print(r);
+        r = g * Bump(3) - g;
+        print(r);
+        r = Difference(g, Bump(4));
+        print(r);
+        print(g < Bump(1))
+    end.
+")
+
+function(run mode result)
+    execute_process(COMMAND ${FRACTUS} ${mode} order.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_VARIABLE output RESULT_VARIABLE status)
+    if (NOT status EQUAL 0)
+        message(FATAL_ERROR "${mode}: exited with ${status}\n${output}")
+    endif()
+    set(${result} "${output}" PARENT_SCOPE)
+endfunction()
+
+run("" expected)
+if (NOT expected MATCHES "Interpreting...\n\n12\n21\n11\nfalse\n")
+    message(FATAL_ERROR "tree walker: unexpected output\n${expected}")
+endif()
+foreach (mode --vm --reg --jit)
+    run(${mode} output)
+    if (NOT output STREQUAL expected)
+        message(FATAL_ERROR "${mode}: output differs from tree walker\n${output}\nexpected\n${expected}")
+    endif()
+endforeach()
@@ -0,0 +1,44 @@
+#
+# -O0 keeps the checked tree, -O1 folds constants and constant conditions.
+# Tree is observed through C++ source written by --emit-cpp.
+# Variables: FRACTUS (interpreter executable), WORK_DIR
+#
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(program "program levels;\n    var x: integer;\n    begin\n        x = 2 * 3;\n        if (1 < 2) then print(x)\n    end.\n")
+
+function(emit level result)
+    file(WRITE ${WORK_DIR}/levels${level}.txt "${program}")
+    execute_process(COMMAND ${FRACTUS} -O${level} --emit-cpp levels${level}.txt
+                    WORKING_DIRECTORY ${WORK_DIR} OUTPUT_QUIET RESULT_VARIABLE status)
+    if (NOT status EQUAL 0 OR NOT EXISTS ${WORK_DIR}/levels${level}.cpp)
+        message(FATAL_ERROR "-O${level}: C++ source was not written")
+    endif()
+    file(READ ${WORK_DIR}/levels${level}.cpp source)
+    set(${result} "${source}" PARENT_SCOPE)
+endfunction()
+
+function(expect source text present)
+    string(FIND "${source}" "${text}" position)
+    if (present AND position EQUAL -1)
+        message(FATAL_ERROR "missing '${text}' in:\n${source}")
+    elseif (NOT present AND NOT position EQUAL -1)
+        message(FATAL_ERROR "unexpected '${text}' in:\n${source}")
+    endif()
+endfunction()
+
+emit(0 unchanged)
+expect("${unchanged}" "v_x = (2 * 3);" TRUE)
+expect("${unchanged}" "if ((1 < 2))" TRUE)
+
+emit(1 folded)
+expect("${folded}" "v_x = 6;" TRUE)
+expect("${folded}" "if (" FALSE)
+expect("${folded}" "fractus::print(v_x);" TRUE)
+
+# integer operations which overflow are left to be run
+set(program "program levels;\n    var x: integer;\n    integer Never(integer n);\n        begin\n            return (0 - 2147483647 - 1) / (0 - 1)\n        end;\n\n    begin\n        x = 2147483647 + 1;\n        x = 65536 * 65536\n    end.\n")
+emit(1 overflowing)
+expect("${overflowing}" "fractus::divide((-2147483647 - 1), (-1));" TRUE)
+expect("${overflowing}" "v_x = (2147483647 + 1);" TRUE)
+expect("${overflowing}" "v_x = (65536 * 65536);" TRUE)